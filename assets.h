@@ -0,0 +1,106 @@
+#pragma once
+
+// Fonts, textures and texts loaded once and shared by every window. A font owns its glyph
+// atlas, so drawing every label with the same sf::Font instance means glyphs are rasterized
+// once per character size for the whole game instead of once per frame.
+
+#include <SFML/Graphics.hpp>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+using namespace std;
+
+class AssetManager
+{
+public:
+    AssetManager()
+    {
+        paths["font"] = "C:/Users/Acer/Downloads/cooper.ttf";
+        paths["background"] = "C:/Users/Acer/Downloads/background.gif";
+    }
+
+    // Overrides asset paths from "name = path" lines. A missing file keeps the defaults.
+    void loadConfig(const string& fileName)
+    {
+        ifstream file(fileName);
+        string line;
+        while (getline(file, line))
+        {
+            size_t separator = line.find('=');
+            if (line.empty() || line[0] == '#' || separator == string::npos)
+                continue;
+            string name = trim(line.substr(0, separator));
+            string path = trim(line.substr(separator + 1));
+            if (!name.empty() && !path.empty())
+                paths[name] = path;
+        }
+    }
+
+    string path(const string& name) const
+    {
+        auto it = paths.find(name);
+        return it != paths.end() ? it->second : name;
+    }
+
+    // Loaded on first use; nullptr if the file could not be loaded. Failures are cached too,
+    // so a missing asset costs one disk access rather than one per frame.
+    const sf::Font* font(const string& name)
+    {
+        auto it = fonts.find(name);
+        if (it == fonts.end())
+        {
+            unique_ptr<sf::Font> font(new sf::Font());
+            if (!font->loadFromFile(path(name)))
+                font.reset();
+            it = fonts.emplace(name, std::move(font)).first;
+        }
+        return it->second.get();
+    }
+
+    const sf::Texture* texture(const string& name)
+    {
+        auto it = textures.find(name);
+        if (it == textures.end())
+        {
+            unique_ptr<sf::Texture> texture(new sf::Texture());
+            if (!texture->loadFromFile(path(name)))
+                texture.reset();
+            it = textures.emplace(name, std::move(texture)).first;
+        }
+        return it->second.get();
+    }
+
+    // A text built once per (font, string, size); callers only move and recolor it. The
+    // returned reference stays valid for the lifetime of the manager.
+    sf::Text& text(const string& fontName, const string& str, unsigned size)
+    {
+        auto key = make_tuple(fontName, str, size);
+        auto it = texts.find(key);
+        if (it == texts.end())
+        {
+            sf::Text text;
+            if (const sf::Font* textFont = font(fontName))
+                text.setFont(*textFont);
+            text.setString(str);
+            text.setCharacterSize(size);
+            it = texts.emplace(key, text).first;
+        }
+        return it->second;
+    }
+
+private:
+    static string trim(const string& s)
+    {
+        size_t first = s.find_first_not_of(" \t\r");
+        size_t last = s.find_last_not_of(" \t\r");
+        return first == string::npos ? string() : s.substr(first, last - first + 1);
+    }
+
+    map<string, string> paths;
+    map<string, unique_ptr<sf::Font>> fonts;
+    map<string, unique_ptr<sf::Texture>> textures;
+    map<tuple<string, string, unsigned>, sf::Text> texts;
+};
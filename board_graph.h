@@ -0,0 +1,159 @@
+#pragma once
+
+// The graph the user draws on the board, as one structure of arrays. Vertices and edges are
+// numbered in the order they are added and keep their numbers. Each vertex has a position
+// and a degree; each edge has its endpoints, its kind and its place among the edges joining
+// the same two vertices. How many edges join a pair of vertices is kept in a flat
+// open-addressing table, so degree, adjacency and multiplicity queries are O(1), and each
+// vertex lists the ids of its edges, so its incident edges are found in O(degree). Shapes,
+// curves and labels are drawn from this model and are not stored here.
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+enum class EdgeKind : uint8_t
+{
+    Simple, // the first edge between two vertices
+    Multi, // a parallel edge
+    Loop,
+};
+
+class BoardGraph
+{
+public:
+    int addVertex(float x, float y)
+    {
+        positionX.push_back(x);
+        positionY.push_back(y);
+        vertexDegrees.push_back(0);
+        incidentEdges.emplace_back();
+        return (int)positionX.size() - 1;
+    }
+
+    void setPosition(int v, float x, float y)
+    {
+        positionX[v] = x;
+        positionY[v] = y;
+    }
+
+    // Adds an edge, or a loop if u == v, and returns its id.
+    int addEdge(int u, int v)
+    {
+        int count = pairs.increment(pairKey(u, v));
+        edgeEndpoints.emplace_back(u, v);
+        edgeKinds.push_back(u == v ? EdgeKind::Loop : count > 1 ? EdgeKind::Multi : EdgeKind::Simple);
+        edgeParallelIndex.push_back((uint8_t)min(count - 1, 255));
+        vertexDegrees[u]++;
+        vertexDegrees[v]++; // a loop counts twice
+        int e = (int)edgeEndpoints.size() - 1;
+        incidentEdges[u].push_back(e);
+        if (v != u)
+            incidentEdges[v].push_back(e);
+        return e;
+    }
+
+    int numVertices() const { return (int)positionX.size(); }
+    int numEdges() const { return (int)edgeEndpoints.size(); }
+
+    float x(int v) const { return positionX[v]; }
+    float y(int v) const { return positionY[v]; }
+    int degree(int v) const { return vertexDegrees[v]; }
+    const vector<int>& degrees() const { return vertexDegrees; }
+
+    // Number of edges between u and v (loops at u if u == v).
+    int multiplicity(int u, int v) const { return pairs.find(pairKey(u, v)); }
+    bool adjacent(int u, int v) const { return multiplicity(u, v) > 0; }
+
+    const pair<int, int>& endpoints(int e) const { return edgeEndpoints[e]; }
+    EdgeKind kind(int e) const { return edgeKinds[e]; }
+    // 0 for the first edge between its endpoints, 1 for the next, and so on.
+    int parallelIndex(int e) const { return edgeParallelIndex[e]; }
+
+    // Every edge in drawing order, loops as (v, v), as the graph routines take them.
+    const vector<pair<int, int>>& edges() const { return edgeEndpoints; }
+
+    // Calls visit(e) once for every edge with an endpoint at v, loops included, in drawing
+    // order; O(degree).
+    template <typename Visitor>
+    void forEachIncidentEdge(int v, Visitor visit) const
+    {
+        for (int e : incidentEdges[v])
+            visit(e);
+    }
+
+private:
+    // Open addressing with linear probing over a power-of-two table; keys are never removed.
+    class PairTable
+    {
+    public:
+        int find(uint64_t key) const
+        {
+            if (keys.empty())
+                return 0;
+            for (size_t i = slot(key);; i = (i + 1) & (keys.size() - 1))
+            {
+                if (keys[i] == key)
+                    return counts[i];
+                if (keys[i] == Empty)
+                    return 0;
+            }
+        }
+
+        // Returns the count after incrementing.
+        int increment(uint64_t key)
+        {
+            if (2 * (used + 1) > keys.size())
+                grow();
+            size_t i = slot(key);
+            while (keys[i] != key && keys[i] != Empty)
+                i = (i + 1) & (keys.size() - 1);
+            if (keys[i] == Empty)
+            {
+                keys[i] = key;
+                ++used;
+            }
+            return ++counts[i];
+        }
+
+    private:
+        static constexpr uint64_t Empty = ~uint64_t(0);
+
+        size_t slot(uint64_t key) const { return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (keys.size() - 1); }
+
+        void grow()
+        {
+            vector<uint64_t> oldKeys(max<size_t>(16, 2 * keys.size()), Empty); // swapped with the live table below
+            vector<int> oldCounts(oldKeys.size(), 0);
+            oldKeys.swap(keys);
+            oldCounts.swap(counts);
+            for (size_t i = 0; i < oldKeys.size(); ++i)
+            {
+                if (oldKeys[i] == Empty)
+                    continue;
+                size_t j = slot(oldKeys[i]);
+                while (keys[j] != Empty)
+                    j = (j + 1) & (keys.size() - 1);
+                keys[j] = oldKeys[i];
+                counts[j] = oldCounts[i];
+            }
+        }
+
+        vector<uint64_t> keys;
+        vector<int> counts;
+        size_t used = 0;
+    };
+
+    static uint64_t pairKey(int u, int v) { return (uint64_t)(uint32_t)min(u, v) << 32 | (uint32_t)max(u, v); }
+
+    vector<float> positionX, positionY;
+    vector<int> vertexDegrees;
+    vector<vector<int>> incidentEdges; // edge ids per vertex, a loop once
+    vector<pair<int, int>> edgeEndpoints;
+    vector<EdgeKind> edgeKinds;
+    vector<uint8_t> edgeParallelIndex;
+    PairTable pairs;
+};
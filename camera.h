@@ -0,0 +1,74 @@
+#pragma once
+
+// Pan and zoom for one window. The mouse wheel zooms around the cursor, dragging with the
+// pan button moves the view, Home resets it, and resizing the window shows more of the
+// world instead of stretching it.
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+
+class Camera
+{
+public:
+    Camera(sf::RenderWindow& window, sf::Mouse::Button panButton)
+        : window(window), panButton(panButton), view(window.getDefaultView()) {}
+
+    // Returns true when the event changed the view.
+    bool handleEvent(const sf::Event& event)
+    {
+        if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+        {
+            sf::Vector2i pixel(event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+            sf::Vector2f before = toWorld(pixel);
+            float factor = pow(ZoomStep, -event.mouseWheelScroll.delta);
+            view.zoom(factor);
+            zoomLevel *= factor;
+            view.move(before - toWorld(pixel));
+            return true;
+        }
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == panButton)
+        {
+            panning = true;
+            lastPixel = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        }
+        else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == panButton)
+        {
+            panning = false;
+        }
+        else if (event.type == sf::Event::MouseMoved && panning)
+        {
+            sf::Vector2i pixel(event.mouseMove.x, event.mouseMove.y);
+            view.move(toWorld(lastPixel) - toWorld(pixel));
+            lastPixel = pixel;
+            return true;
+        }
+        else if (event.type == sf::Event::Resized)
+        {
+            view.setSize(event.size.width * zoomLevel, event.size.height * zoomLevel);
+            return true;
+        }
+        else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Home)
+        {
+            sf::Vector2u size = window.getSize();
+            view.reset(sf::FloatRect(0, 0, (float)size.x, (float)size.y));
+            zoomLevel = 1.0f;
+            return true;
+        }
+        return false;
+    }
+
+    const sf::View& getView() const { return view; }
+    bool isPanning() const { return panning; }
+
+    sf::Vector2f toWorld(sf::Vector2i pixel) const { return window.mapPixelToCoords(pixel, view); }
+
+private:
+    static constexpr float ZoomStep = 1.15f; // per wheel notch
+
+    sf::RenderWindow& window;
+    sf::Mouse::Button panButton;
+    sf::View view;
+    float zoomLevel = 1.0f;
+    bool panning = false;
+    sf::Vector2i lastPixel;
+};
@@ -0,0 +1,103 @@
+// Offline builder for graph_catalog.bin: enumerates every simple graph up to isomorphism
+// for each vertex count in range and up to the edge limit, and writes the sorted records
+// the game maps at startup.
+//
+// usage: catalog_builder [output] [minVertices] [maxVertices] [maxEdges]
+
+#include <iostream>
+#include <fstream>
+#include <set>
+#include "graph_catalog.h"
+
+using namespace std;
+
+struct EnumeratedGraphs
+{
+    vector<CatalogRecord> records;
+    vector<size_t> levelSizes; // graphs per edge count, from 0
+};
+
+// All classes on numVertices vertices with 0..maxEdges edges. Level m + 1 is every level m
+// class plus one missing edge, deduplicated by canonical adjacency bits.
+EnumeratedGraphs enumerateGraphs(int numVertices, int maxEdges)
+{
+    EnumeratedGraphs result;
+    vector<CatalogRecord>& records = result.records;
+    CatalogRecord empty;
+    makeCatalogRecord(buildCsrGraph(numVertices, vector<pair<int, int>>()), empty);
+    vector<CatalogRecord> level = { empty };
+    int totalPairs = numVertices * (numVertices - 1) / 2;
+
+    for (int m = 0; m <= min(maxEdges, totalPairs); ++m)
+    {
+        records.insert(records.end(), level.begin(), level.end());
+        result.levelSizes.push_back(level.size());
+        if (m == min(maxEdges, totalPairs))
+            break;
+
+        set<uint64_t> seen;
+        vector<CatalogRecord> next;
+        for (const auto& record : level)
+        {
+            vector<pair<int, int>> edges = catalogRecordEdges(record);
+            for (int k = 0; k < totalPairs; ++k)
+            {
+                if ((record.adjacency >> k) & 1)
+                    continue;
+                edges.push_back(pairFromIndex(numVertices, k));
+                CatalogRecord extended;
+                makeCatalogRecord(buildCsrGraph(numVertices, edges), extended);
+                if (seen.insert(extended.adjacency).second)
+                    next.push_back(extended);
+                edges.pop_back();
+            }
+        }
+        level = std::move(next);
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    string output = argc > 1 ? argv[1] : "graph_catalog.bin";
+    int minVertices = argc > 2 ? atoi(argv[2]) : 4;
+    int maxVertices = argc > 3 ? atoi(argv[3]) : CatalogMaxVertices;
+    int maxEdges = argc > 4 ? atoi(argv[4]) : 10;
+    if (minVertices < 1 || maxVertices > CatalogMaxVertices || minVertices > maxVertices || maxEdges < 0)
+    {
+        cout << "Vertex range must be within 1-" << CatalogMaxVertices << " and maxEdges non-negative" << endl;
+        return 1;
+    }
+
+    // Each vertex count is independent, so they are enumerated in parallel; progress is
+    // printed here, in order, rather than from the jobs.
+    vector<future<EnumeratedGraphs>> jobs;
+    for (int n = minVertices; n <= maxVertices; ++n)
+        jobs.push_back(async(launch::async, enumerateGraphs, n, maxEdges));
+    vector<CatalogRecord> records;
+    for (int i = 0; i < (int)jobs.size(); ++i)
+    {
+        EnumeratedGraphs part = jobs[i].get();
+        for (size_t m = 1; m < part.levelSizes.size(); ++m)
+            cout << "  " << minVertices + i << " vertices, " << m << " edges: " << part.levelSizes[m] << " graphs" << endl;
+        records.insert(records.end(), part.records.begin(), part.records.end());
+    }
+    sort(records.begin(), records.end());
+
+    CatalogHeader header;
+    memcpy(header.magic, CatalogMagic, sizeof(CatalogMagic));
+    header.version = 1;
+    header.recordSize = sizeof(CatalogRecord);
+    header.recordCount = records.size();
+
+    ofstream file(output, ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(CatalogRecord));
+    if (!file)
+    {
+        cout << "Failed to write " << output << endl;
+        return 1;
+    }
+    cout << "Wrote " << records.size() << " graphs to " << output << endl;
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+// Spring-electrical layout (Fruchterman-Reingold): edges pull their endpoints together,
+// every pair of vertices pushes apart, and a cooling temperature caps how far a vertex may
+// move per iteration. Repulsion is approximated with a Barnes-Hut quadtree, so an
+// iteration costs O(n log n) instead of O(n^2), and the force pass is split across a
+// thread pool for large graphs. Vertices move freely and the result is scaled to fit the
+// box, so nothing piles up against the borders. The layout advances a few iterations at a
+// time, so a render loop can call step() once per frame and stay responsive while it
+// converges.
+
+#include <cmath>
+#include <vector>
+#include "graph.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+class ForceLayout
+{
+public:
+    // Starts from uniformly random positions inside the box [margin, size - margin].
+    ForceLayout(const CsrGraph& graph, float width, float height, float margin, mt19937& gen, int numThreads = 0)
+        : graph(graph), width(width), height(height), margin(margin),
+        x(graph.numVertices), y(graph.numVertices), dx(graph.numVertices), dy(graph.numVertices), pinned(graph.numVertices, 0)
+    {
+        int n = max(1, graph.numVertices);
+        uniform_real_distribution<float> randomX(margin, width - margin), randomY(margin, height - margin);
+        for (int v = 0; v < graph.numVertices; ++v)
+        {
+            x[v] = randomX(gen);
+            y[v] = randomY(gen);
+        }
+        k = 0.75f * sqrt((width - 2 * margin) * (height - 2 * margin) / n);
+        temperature = (width - 2 * margin) / 10;
+        if (graph.numVertices >= ParallelThreshold)
+            pool.reset(new ThreadPool(numThreads));
+        fitToBox();
+    }
+
+    int numVertices() const { return graph.numVertices; }
+    // Positions in box coordinates.
+    float positionX(int v) const { return x[v] * scale + offsetX; }
+    float positionY(int v) const { return y[v] * scale + offsetY; }
+
+    // Moves a vertex, in box coordinates; pinned vertices keep their position, e.g. while
+    // the user drags them.
+    void setPosition(int v, float px, float py)
+    {
+        x[v] = (px - offsetX) / scale;
+        y[v] = (py - offsetY) / scale;
+    }
+    void pin(int v, bool isPinned) { pinned[v] = isPinned; }
+
+    // Reheats the layout after the graph or a position changed.
+    void restart(float newTemperature)
+    {
+        temperature = newTemperature;
+        done = false;
+    }
+
+    bool converged() const { return done; }
+
+    // Runs up to `iterations` iterations and returns true once the layout has converged:
+    // the temperature has cooled down or no vertex moved more than half a pixel.
+    bool step(int iterations = 1)
+    {
+        for (int i = 0; i < iterations && !done && graph.numVertices > 0; ++i)
+        {
+            TRACE_SCOPE_ARG("layout iteration", "vertices", graph.numVertices);
+            buildQuadtree();
+            parallelFor(graph.numVertices, [this](int first, int last) { computeForces(first, last); });
+            float maxMove = 0;
+            for (int v = 0; v < graph.numVertices; ++v)
+            {
+                if (pinned[v])
+                    continue;
+                float length = sqrt(dx[v] * dx[v] + dy[v] * dy[v]);
+                if (length < 1e-6f)
+                    continue;
+                float move = min(length, temperature);
+                x[v] += dx[v] / length * move;
+                y[v] += dy[v] / length * move;
+                maxMove = max(maxMove, move);
+            }
+            temperature *= CoolingFactor;
+            fitToBox();
+            done = temperature * scale < 0.5f || maxMove * scale < 0.5f;
+        }
+        return done;
+    }
+
+private:
+    static const int ParallelThreshold = 2048;
+    static const int MaxDepth = 24; // coincident vertices share a leaf below this
+    static constexpr float Theta = 0.9f; // cell size / distance below which a cell is one body
+    static constexpr float CoolingFactor = 0.97f;
+
+    struct QuadNode
+    {
+        float centerX = 0, centerY = 0, mass = 0;
+        float left, top, size;
+        int children = -1; // index of the first of four consecutive children
+        int body = -1;
+    };
+
+    // Chooses the scale and offset that center the bounding box of the layout in the box.
+    void fitToBox()
+    {
+        if (graph.numVertices == 0)
+            return;
+        float minX = *min_element(x.begin(), x.end()), maxX = *max_element(x.begin(), x.end());
+        float minY = *min_element(y.begin(), y.end()), maxY = *max_element(y.begin(), y.end());
+        float spanX = max(maxX - minX, 1e-3f), spanY = max(maxY - minY, 1e-3f);
+        scale = min((width - 2 * margin) / spanX, (height - 2 * margin) / spanY);
+        offsetX = width / 2 - (minX + maxX) / 2 * scale;
+        offsetY = height / 2 - (minY + maxY) / 2 * scale;
+    }
+
+    void buildQuadtree()
+    {
+        nodes.clear();
+        float minX = *min_element(x.begin(), x.end()), maxX = *max_element(x.begin(), x.end());
+        float minY = *min_element(y.begin(), y.end()), maxY = *max_element(y.begin(), y.end());
+        float size = max(max(maxX - minX, maxY - minY), 1.0f) * 1.001f;
+        nodes.push_back(QuadNode{ 0, 0, 0, minX, minY, size });
+        for (int v = 0; v < graph.numVertices; ++v)
+            insert(v);
+    }
+
+    int quadrant(const QuadNode& node, float px, float py) const
+    {
+        float half = node.size / 2;
+        return (px >= node.left + half ? 1 : 0) + (py >= node.top + half ? 2 : 0);
+    }
+
+    void insert(int v)
+    {
+        int index = 0;
+        for (int depth = 0;; ++depth)
+        {
+            QuadNode& node = nodes[index];
+            if (node.mass == 0)
+            {
+                node.body = v;
+                node.mass = 1;
+                node.centerX = x[v];
+                node.centerY = y[v];
+                return;
+            }
+            if (node.children < 0 && depth >= MaxDepth)
+            {
+                node.centerX = (node.centerX * node.mass + x[v]) / (node.mass + 1);
+                node.centerY = (node.centerY * node.mass + y[v]) / (node.mass + 1);
+                node.mass += 1;
+                return;
+            }
+            if (node.children < 0)
+            {
+                // Split the leaf and push its body one level down
+                int first = (int)nodes.size();
+                float half = node.size / 2;
+                float left = node.left, top = node.top;
+                int body = node.body;
+                for (int q = 0; q < 4; ++q)
+                    nodes.push_back(QuadNode{ 0, 0, 0, left + (q & 1) * half, top + (q >> 1) * half, half });
+                QuadNode& parent = nodes[index]; // push_back may have moved it
+                parent.children = first;
+                parent.body = -1;
+                QuadNode& child = nodes[first + quadrant(parent, x[body], y[body])];
+                child.body = body;
+                child.mass = 1;
+                child.centerX = x[body];
+                child.centerY = y[body];
+            }
+            QuadNode& parent = nodes[index];
+            parent.centerX = (parent.centerX * parent.mass + x[v]) / (parent.mass + 1);
+            parent.centerY = (parent.centerY * parent.mass + y[v]) / (parent.mass + 1);
+            parent.mass += 1;
+            index = parent.children + quadrant(parent, x[v], y[v]);
+        }
+    }
+
+    void computeForces(int first, int last)
+    {
+        vector<int> stack;
+        float k2 = k * k;
+        for (int v = first; v < last; ++v)
+        {
+            float fx = 0, fy = 0;
+            stack.assign(1, 0);
+            while (!stack.empty())
+            {
+                const QuadNode& node = nodes[stack.back()];
+                stack.pop_back();
+                float mass = node.mass;
+                if (node.body == v)
+                    mass -= 1;
+                if (mass <= 0)
+                    continue;
+                float ddx = x[v] - node.centerX, ddy = y[v] - node.centerY;
+                float distance2 = ddx * ddx + ddy * ddy;
+                if (node.children >= 0 && node.size * node.size >= Theta * Theta * distance2)
+                {
+                    for (int q = 0; q < 4; ++q)
+                        stack.push_back(node.children + q);
+                    continue;
+                }
+                if (distance2 < 0.01f)
+                {
+                    // Coincident vertices: push apart along a direction derived from the index
+                    ddx = cos((float)v);
+                    ddy = sin((float)v);
+                    distance2 = 1;
+                }
+                float scale = k2 * mass / distance2; // k^2 / d, times the unit direction d / |d|
+                fx += ddx * scale;
+                fy += ddy * scale;
+            }
+            for (const int* u = graph.begin(v); u != graph.end(v); ++u)
+            {
+                if (*u == v)
+                    continue;
+                float ddx = x[*u] - x[v], ddy = y[*u] - y[v];
+                float distance = sqrt(ddx * ddx + ddy * ddy);
+                fx += ddx * distance / k; // d^2 / k along the unit direction
+                fy += ddy * distance / k;
+            }
+            dx[v] = fx;
+            dy[v] = fy;
+        }
+    }
+
+    template <typename Body>
+    void parallelFor(int count, Body body)
+    {
+        if (!pool)
+        {
+            body(0, count);
+            return;
+        }
+        int chunks = 4 * pool->size();
+        int chunkSize = (count + chunks - 1) / chunks;
+        vector<future<void>> pending;
+        for (int first = 0; first < count; first += chunkSize)
+        {
+            int last = min(count, first + chunkSize);
+            pending.push_back(pool->submit([=]() { body(first, last); }));
+        }
+        for (auto& task : pending)
+            task.get();
+    }
+
+    const CsrGraph& graph;
+    float width, height, margin;
+    float k;
+    float temperature;
+    float scale = 1, offsetX = 0, offsetY = 0;
+    bool done = false;
+    vector<float> x, y, dx, dy;
+    vector<char> pinned;
+    vector<QuadNode> nodes;
+    unique_ptr<ThreadPool> pool;
+};
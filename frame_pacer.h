@@ -0,0 +1,90 @@
+#pragma once
+
+// Decides when a window is redrawn. Nothing is drawn unless something changed: callers
+// invalidate() after an edit, mark the window animating while a drag, rubber band or
+// layout is in progress (redrawn at the target frame rate), or schedule a one-off redraw
+// for a timed animation step. In between, nextEvent blocks in waitEvent, so an idle window
+// costs no CPU.
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+
+class FramePacer
+{
+public:
+    explicit FramePacer(unsigned framesPerSecond = 60) { setFrameRate(framesPerSecond); }
+
+    void setFrameRate(unsigned framesPerSecond) { frameMicroseconds = 1000000 / std::max(1u, framesPerSecond); }
+
+    void invalidate() { dirty = true; }
+    void setAnimating(bool isAnimating) { animating = isAnimating; }
+    bool isAnimating() const { return animating; }
+
+    // Requests a redraw after `delay`, e.g. the next tick of a timed animation.
+    void scheduleIn(sf::Time delay) { deadline = now() + std::max<int64_t>(0, delay.asMicroseconds()); }
+
+    // Microseconds until a redraw is due, or -1 when the window is idle.
+    int64_t microsecondsUntilDue() const
+    {
+        int64_t due = -1;
+        if (dirty)
+            return 0;
+        if (animating)
+            due = std::max<int64_t>(0, lastFrame + frameMicroseconds - now());
+        if (deadline >= 0)
+        {
+            int64_t untilDeadline = std::max<int64_t>(0, deadline - now());
+            due = due < 0 ? untilDeadline : std::min(due, untilDeadline);
+        }
+        return due;
+    }
+
+    bool needsRedraw() const { return microsecondsUntilDue() == 0; }
+
+    void frameDrawn()
+    {
+        dirty = false;
+        deadline = -1;
+        lastFrame = now();
+    }
+
+    // Returns the next pending event, blocking until one arrives while the window is idle
+    // or sleeping until the next frame is due. Returns false when it is time to draw.
+    bool nextEvent(sf::Window& window, sf::Event& event) { return nextEvent(window, event, LiveEvents()); }
+
+    // Same, with events taken from `events` (poll and wait, like the window's own pollEvent
+    // and waitEvent), e.g. an InputLog that records or replays them.
+    template <typename Events>
+    bool nextEvent(sf::Window& window, sf::Event& event, Events events)
+    {
+        if (events.poll(window, event))
+            return true;
+        int64_t due = microsecondsUntilDue();
+        if (due == 0)
+            return false;
+        if (due < 0)
+            return events.wait(window, event);
+        sf::sleep(sf::microseconds(std::min(due, MaxSleepMicroseconds)));
+        return events.poll(window, event);
+    }
+
+private:
+    struct LiveEvents
+    {
+        bool poll(sf::Window& window, sf::Event& event) { return window.pollEvent(event); }
+        bool wait(sf::Window& window, sf::Event& event) { return window.waitEvent(event); }
+    };
+
+    // Caps a sleep so input that arrives meanwhile is picked up within a few milliseconds.
+    static constexpr int64_t MaxSleepMicroseconds = 4000;
+
+    int64_t now() const { return clock.getElapsedTime().asMicroseconds(); }
+
+    sf::Clock clock;
+    int64_t frameMicroseconds = 16666;
+    int64_t lastFrame = 0;
+    int64_t deadline = -1;
+    bool dirty = true; // the first frame is always drawn
+    bool animating = false;
+};
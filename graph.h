@@ -0,0 +1,2053 @@
+#pragma once
+
+// Graph core shared by the game, the catalog builder and the other tools: adjacency
+// representations, generators, isomorphism and canonical labeling. Nothing in here
+// depends on SFML.
+
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cstdint>
+#include <new>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <list>
+#include "trace.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+inline int popcount64(uint64_t word)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+inline int countTrailingZeros64(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Allocator that hands out storage aligned for 256-bit loads.
+template <typename T>
+struct AlignedAllocator
+{
+    typedef T value_type;
+    static const size_t Alignment = 32;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), align_val_t(Alignment)));
+    }
+    void deallocate(T* pointer, size_t)
+    {
+        ::operator delete(pointer, align_val_t(Alignment));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+#if defined(__AVX2__)
+// Per-byte popcount of a 256-bit register (nibble lookup), summed into four 64-bit lanes.
+inline __m256i popcount256(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_and_si256(v, lowMask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+inline int horizontalSum256(__m256i v)
+{
+    return (int)(_mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3));
+}
+#endif
+
+// Number of set bits in a row. `words` is a multiple of 4 and `row` is 32-byte aligned.
+inline int popcountRow(const uint64_t* row, int words)
+{
+#if defined(__AVX2__)
+    __m256i total = _mm256_setzero_si256();
+    for (int i = 0; i < words; i += 4)
+        total = _mm256_add_epi64(total, popcount256(_mm256_load_si256((const __m256i*)(row + i))));
+    return horizontalSum256(total);
+#else
+    int total = 0;
+    for (int i = 0; i < words; ++i)
+        total += popcount64(row[i]);
+    return total;
+#endif
+}
+
+// Number of bits set in both rows.
+inline int popcountAnd(const uint64_t* row1, const uint64_t* row2, int words)
+{
+#if defined(__AVX2__)
+    __m256i total = _mm256_setzero_si256();
+    for (int i = 0; i < words; i += 4)
+    {
+        __m256i both = _mm256_and_si256(_mm256_load_si256((const __m256i*)(row1 + i)), _mm256_load_si256((const __m256i*)(row2 + i)));
+        total = _mm256_add_epi64(total, popcount256(both));
+    }
+    return horizontalSum256(total);
+#else
+    int total = 0;
+    for (int i = 0; i < words; ++i)
+        total += popcount64(row1[i] & row2[i]);
+    return total;
+#endif
+}
+
+// Simple undirected graph stored as a contiguous bit matrix: row i holds one bit per
+// vertex, packed into 64-bit words. Rows are padded to a multiple of 256 bits so the
+// kernels above can use aligned AVX2 loads without tail handling.
+struct BitGraph
+{
+    int numVertices = 0;
+    int wordsPerRow = 0;
+    vector<uint64_t, AlignedAllocator<uint64_t>> bits;
+
+    BitGraph() = default;
+    explicit BitGraph(int vertices)
+        : numVertices(vertices), wordsPerRow(((vertices + 255) / 256) * 4), bits((size_t)vertices * wordsPerRow, 0) {}
+
+    const uint64_t* row(int v) const { return bits.data() + (size_t)v * wordsPerRow; }
+    uint64_t* row(int v) { return bits.data() + (size_t)v * wordsPerRow; }
+
+    bool hasEdge(int v1, int v2) const
+    {
+        return (row(v1)[v2 >> 6] >> (v2 & 63)) & 1;
+    }
+    void addEdge(int v1, int v2)
+    {
+        row(v1)[v2 >> 6] |= uint64_t(1) << (v2 & 63);
+        row(v2)[v1 >> 6] |= uint64_t(1) << (v1 & 63);
+    }
+    void removeEdge(int v1, int v2)
+    {
+        row(v1)[v2 >> 6] &= ~(uint64_t(1) << (v2 & 63));
+        row(v2)[v1 >> 6] &= ~(uint64_t(1) << (v1 & 63));
+    }
+    int degree(int v) const { return popcountRow(row(v), wordsPerRow); }
+    int countEdges() const
+    {
+        return popcountRow(bits.data(), (int)bits.size()) / 2;
+    }
+};
+
+// Calls visit(u) for every neighbor u of v, in increasing order.
+template <typename Visitor>
+void forEachNeighbor(const BitGraph& graph, int v, Visitor visit)
+{
+    const uint64_t* row = graph.row(v);
+    for (int w = 0; w < graph.wordsPerRow; ++w)
+    {
+        for (uint64_t word = row[w]; word != 0; word &= word - 1)
+            visit(w * 64 + countTrailingZeros64(word));
+    }
+}
+
+// Number of vertices adjacent to both v1 and v2.
+inline int countCommonNeighbors(const BitGraph& graph, int v1, int v2)
+{
+    return popcountAnd(graph.row(v1), graph.row(v2), graph.wordsPerRow);
+}
+
+// Writes the common neighborhood of v1 and v2 into `out` (wordsPerRow words).
+inline void intersectNeighbors(const BitGraph& graph, int v1, int v2, uint64_t* out)
+{
+    const uint64_t* row1 = graph.row(v1);
+    const uint64_t* row2 = graph.row(v2);
+    for (int w = 0; w < graph.wordsPerRow; ++w)
+        out[w] = row1[w] & row2[w];
+}
+
+// Calls visit(i, j) once per edge with i < j.
+template <typename Visitor>
+void forEachEdge(const BitGraph& graph, Visitor visit)
+{
+    for (int i = 0; i < graph.numVertices; ++i)
+    {
+        forEachNeighbor(graph, i, [&](int j) {
+            if (i < j)
+                visit(i, j);
+            });
+    }
+}
+
+// Compressed sparse row graph for inputs too large for a V x V matrix. The neighbors of
+// v are neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1], sorted. An edge u-v is
+// stored in both lists, a parallel edge is a repeated entry and a loop appears once in
+// its vertex's list, so the list length matches calculateDegrees on a matrix.
+struct CsrGraph
+{
+    int numVertices = 0;
+    vector<int> offsets;   // numVertices + 1 entries
+    vector<int> neighbors; // 2 * edges - loops entries
+
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const int* begin(int v) const { return neighbors.data() + offsets[v]; }
+    const int* end(int v) const { return neighbors.data() + offsets[v + 1]; }
+};
+
+inline CsrGraph buildCsrGraph(int numVertices, const pair<int, int>* edges, size_t numEdges)
+{
+    CsrGraph graph;
+    graph.numVertices = numVertices;
+    graph.offsets.assign(numVertices + 1, 0);
+    for (size_t e = 0; e < numEdges; ++e)
+    {
+        const auto& edge = edges[e];
+        graph.offsets[edge.first + 1]++;
+        if (edge.first != edge.second)
+            graph.offsets[edge.second + 1]++;
+    }
+    for (int v = 0; v < numVertices; ++v)
+        graph.offsets[v + 1] += graph.offsets[v];
+
+    graph.neighbors.resize(graph.offsets[numVertices]);
+    vector<int> cursor(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (size_t e = 0; e < numEdges; ++e)
+    {
+        const auto& edge = edges[e];
+        graph.neighbors[cursor[edge.first]++] = edge.second;
+        if (edge.first != edge.second)
+            graph.neighbors[cursor[edge.second]++] = edge.first;
+    }
+    for (int v = 0; v < numVertices; ++v)
+        sort(graph.neighbors.begin() + graph.offsets[v], graph.neighbors.begin() + graph.offsets[v + 1]);
+    return graph;
+}
+
+inline CsrGraph buildCsrGraph(int numVertices, const vector<pair<int, int>>& edges)
+{
+    return buildCsrGraph(numVertices, edges.data(), edges.size());
+}
+
+inline CsrGraph buildCsrGraph(const BitGraph& bitGraph)
+{
+    CsrGraph graph;
+    graph.numVertices = bitGraph.numVertices;
+    graph.offsets.assign(bitGraph.numVertices + 1, 0);
+    for (int v = 0; v < bitGraph.numVertices; ++v)
+        graph.offsets[v + 1] = graph.offsets[v] + bitGraph.degree(v);
+    graph.neighbors.reserve(graph.offsets[bitGraph.numVertices]);
+    for (int v = 0; v < bitGraph.numVertices; ++v)
+        forEachNeighbor(bitGraph, v, [&](int u) { graph.neighbors.push_back(u); });
+    return graph;
+}
+
+// Calls visit(i, j) once per edge with i <= j; parallel edges are visited once each.
+template <typename Visitor>
+void forEachEdge(const CsrGraph& graph, Visitor visit)
+{
+    for (int i = 0; i < graph.numVertices; ++i)
+    {
+        for (const int* j = graph.begin(i); j != graph.end(i); ++j)
+        {
+            if (i <= *j)
+                visit(i, *j);
+        }
+    }
+}
+
+// Returns the graph with vertex v renamed to permutation[v], in O(V + E). New vertices are
+// visited in increasing order and appended to their neighbors' lists, so every list comes
+// out sorted without a sort pass.
+inline CsrGraph relabelVertices(const CsrGraph& graph, const vector<int>& permutation)
+{
+    TRACE_SCOPE_ARG("relabelVertices", "vertices", graph.numVertices);
+    int numVertices = graph.numVertices;
+    vector<int> inverse(numVertices);
+    for (int v = 0; v < numVertices; ++v)
+        inverse[permutation[v]] = v;
+
+    CsrGraph relabeled;
+    relabeled.numVertices = numVertices;
+    relabeled.offsets.assign(numVertices + 1, 0);
+    for (int v = 0; v < numVertices; ++v)
+        relabeled.offsets[permutation[v] + 1] = graph.degree(v);
+    for (int v = 0; v < numVertices; ++v)
+        relabeled.offsets[v + 1] += relabeled.offsets[v];
+
+    relabeled.neighbors.resize(graph.neighbors.size());
+    vector<int> cursor(relabeled.offsets.begin(), relabeled.offsets.end() - 1);
+    for (int newVertex = 0; newVertex < numVertices; ++newVertex)
+    {
+        int oldVertex = inverse[newVertex];
+        for (const int* u = graph.begin(oldVertex); u != graph.end(oldVertex); ++u)
+            relabeled.neighbors[cursor[permutation[*u]]++] = newVertex;
+    }
+    return relabeled;
+}
+
+// Fills `permutation` with a uniformly random permutation of 0..size-1, reusing its storage.
+inline void randomPermutation(vector<int>& permutation, int size, mt19937& gen)
+{
+    permutation.resize(size);
+    iota(permutation.begin(), permutation.end(), 0);
+    shuffle(permutation.begin(), permutation.end(), gen);
+}
+
+// Index of the first pair (i, j), j > i, in the row-major list of all n(n-1)/2 pairs.
+inline long long pairRowStart(long long n, long long i)
+{
+    return i * (2 * n - i - 1) / 2;
+}
+
+// Inverse of the row-major pair numbering: returns the k-th pair (i, j) with i < j.
+inline pair<int, int> pairFromIndex(int numVertices, long long k)
+{
+    long long n = numVertices;
+    double b = 2.0 * n - 1;
+    long long i = (long long)((b - sqrt(max(0.0, b * b - 8.0 * k))) / 2);
+    i = max(0LL, min(i, n - 2));
+    while (i > 0 && pairRowStart(n, i) > k)
+        --i;
+    while (i + 1 < n - 1 && pairRowStart(n, i + 1) <= k)
+        ++i;
+    return { (int)i, (int)(k - pairRowStart(n, i) + i + 1) };
+}
+
+// Uniform G(n, m): exactly numEdges distinct edges, no loops. Runs in O(V + E) with no
+// retry loop. Sparse requests use Floyd's algorithm, where every step adds exactly one
+// new pair index. Requests above half density sample the missing pairs instead and emit
+// the rest. Asking for more edges than exist returns the complete graph.
+inline vector<pair<int, int>> generateRandomEdges(int numVertices, long long numEdges, mt19937& gen)
+{
+    TRACE_SCOPE_ARG("generateRandomEdges", "edges", numEdges);
+    long long totalPairs = (long long)numVertices * (numVertices - 1) / 2;
+    numEdges = max(0LL, min(numEdges, totalPairs));
+    vector<pair<int, int>> edges;
+    edges.reserve(numEdges);
+
+    bool complement = numEdges > totalPairs / 2;
+    long long numSampled = complement ? totalPairs - numEdges : numEdges;
+
+    unordered_set<long long> sampled;
+    sampled.reserve(numSampled);
+    for (long long j = totalPairs - numSampled; j < totalPairs; ++j)
+    {
+        long long t = uniform_int_distribution<long long>(0, j)(gen);
+        sampled.insert(sampled.count(t) ? j : t);
+    }
+
+    if (!complement)
+    {
+        for (long long k : sampled)
+            edges.push_back(pairFromIndex(numVertices, k));
+        return edges;
+    }
+    long long k = 0;
+    for (int i = 0; i < numVertices; ++i)
+    {
+        for (int j = i + 1; j < numVertices; ++j, ++k)
+        {
+            if (!sampled.count(k))
+                edges.emplace_back(i, j);
+        }
+    }
+    return edges;
+}
+
+// G(n, p): every pair is an edge independently with probability p. Geometric skipping
+// (Batagelj-Brandes) jumps straight to the next edge, so the cost is O(V + E).
+inline vector<pair<int, int>> generateRandomEdgesWithProbability(int numVertices, double p, mt19937& gen)
+{
+    TRACE_SCOPE_ARG("generateRandomEdgesWithProbability", "vertices", numVertices);
+    vector<pair<int, int>> edges;
+    if (p <= 0 || numVertices < 2)
+        return edges;
+    if (p >= 1)
+        return generateRandomEdges(numVertices, (long long)numVertices * (numVertices - 1) / 2, gen);
+
+    edges.reserve((size_t)(p * numVertices * (numVertices - 1) / 2));
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    double logSkip = log(1.0 - p);
+    long long v = 1;
+    long long w = -1;
+    while (v < numVertices)
+    {
+        w += 1 + (long long)floor(log(1.0 - unit(gen)) / logSkip);
+        while (w >= v && v < numVertices)
+        {
+            w -= v;
+            ++v;
+        }
+        if (v < numVertices)
+            edges.emplace_back((int)w, (int)v);
+    }
+    return edges;
+}
+
+inline long long edgeKey(int v1, int v2)
+{
+    return v1 < v2 ? ((long long)v1 << 32) | v2 : ((long long)v2 << 32) | v1;
+}
+
+// Random double-edge swaps on an edge list: (a, b), (c, d) become (a, d), (c, b) or
+// (a, c), (b, d). Swaps that would create a loop or a new parallel edge are skipped and
+// loops are never moved, so every degree is preserved. Parallel edges already in the input
+// are allowed. The edge multiplicities are counted once, in O(E), and kept up to date, so
+// swaps can be made a few at a time (checking the graph in between) at O(1) each.
+class DoubleEdgeSwapper
+{
+public:
+    explicit DoubleEdgeSwapper(vector<pair<int, int>>& edges) : edges(edges)
+    {
+        multiplicity.reserve(edges.size() * 2);
+        for (const auto& edge : edges)
+            multiplicity[edgeKey(edge.first, edge.second)]++;
+    }
+
+    // Makes `attempts` swap attempts; returns the successful swaps.
+    long long randomize(long long attempts, mt19937& gen)
+    {
+        if (edges.size() < 2)
+            return 0;
+        uniform_int_distribution<size_t> pickEdge(0, edges.size() - 1);
+        long long swaps = 0;
+        for (long long attempt = 0; attempt < attempts; ++attempt)
+        {
+            size_t e1 = pickEdge(gen);
+            size_t e2 = pickEdge(gen);
+            int a = edges[e1].first, b = edges[e1].second;
+            int c = edges[e2].first, d = edges[e2].second;
+            if (gen() & 1)
+                swap(c, d);
+            if (a == b || c == d || a == d || c == b)
+                continue;
+            if (present(a, d) || present(c, b))
+                continue;
+            multiplicity[edgeKey(a, b)]--;
+            multiplicity[edgeKey(c, d)]--;
+            multiplicity[edgeKey(a, d)]++;
+            multiplicity[edgeKey(c, b)]++;
+            edges[e1] = { a, d };
+            edges[e2] = { c, b };
+            swaps++;
+        }
+        return swaps;
+    }
+
+private:
+    bool present(int v1, int v2) const
+    {
+        auto it = multiplicity.find(edgeKey(v1, v2));
+        return it != multiplicity.end() && it->second > 0;
+    }
+
+    vector<pair<int, int>>& edges;
+    unordered_map<long long, int> multiplicity;
+};
+
+// Makes `attempts` random double-edge swaps (see DoubleEdgeSwapper) in O(E + attempts).
+// Returns the successful swaps.
+inline long long randomizeByDoubleEdgeSwaps(vector<pair<int, int>>& edges, long long attempts, mt19937& gen)
+{
+    if (edges.size() < 2)
+        return 0;
+    return DoubleEdgeSwapper(edges).randomize(attempts, gen);
+}
+
+// Simple graph with the given degree sequence. Havel-Hakimi builds one deterministically,
+// taking vertices from degree buckets (O(V * maxDegree + E), no backtracking), and a fixed
+// budget of double-edge swaps then randomizes it. Returns false if the sequence is not
+// graphical.
+inline bool generateRandomEdgesWithDegrees(const vector<int>& degrees, mt19937& gen, vector<pair<int, int>>& edges)
+{
+    TRACE_SCOPE_ARG("generateRandomEdgesWithDegrees", "vertices", degrees.size());
+    int numVertices = degrees.size();
+    edges.clear();
+    long long degreeSum = 0;
+    int maxDegree = 0;
+    for (int d : degrees)
+    {
+        if (d < 0 || d >= max(numVertices, 1))
+            return false;
+        degreeSum += d;
+        maxDegree = max(maxDegree, d);
+    }
+    if (degreeSum % 2 != 0)
+        return false;
+    edges.reserve(degreeSum / 2);
+
+    vector<vector<int>> buckets(maxDegree + 1);
+    vector<int> residual = degrees;
+    vector<int> order(numVertices);
+    randomPermutation(order, numVertices, gen);
+    for (int v : order)
+        buckets[residual[v]].push_back(v);
+
+    vector<int> chosen;
+    int top = maxDegree;
+    while (true)
+    {
+        while (top > 0 && buckets[top].empty())
+            --top;
+        if (top == 0)
+            break;
+        int v = buckets[top].back();
+        buckets[top].pop_back();
+        int needed = residual[v];
+        residual[v] = 0;
+
+        chosen.clear();
+        for (int d = top; d > 0 && (int)chosen.size() < needed; --d)
+        {
+            while (!buckets[d].empty() && (int)chosen.size() < needed)
+            {
+                chosen.push_back(buckets[d].back());
+                buckets[d].pop_back();
+            }
+        }
+        if ((int)chosen.size() < needed)
+            return false;
+        for (int u : chosen)
+        {
+            edges.emplace_back(v, u);
+            buckets[--residual[u]].push_back(u);
+        }
+    }
+
+    randomizeByDoubleEdgeSwaps(edges, 10 * (long long)edges.size(), gen);
+    return true;
+}
+
+inline BitGraph generateRandomGraph(int numVertices, int numEdges, mt19937& gen)
+{
+    TRACE_SCOPE_ARG("generateRandomGraph", "edges", numEdges);
+    BitGraph graph(numVertices);
+    for (const auto& edge : generateRandomEdges(numVertices, numEdges, gen))
+        graph.addEdge(edge.first, edge.second);
+    return graph;
+}
+
+// Renames every endpoint v to permutation[v] in place, in O(E).
+inline void relabelEdges(vector<pair<int, int>>& edges, const vector<int>& permutation)
+{
+    TRACE_SCOPE_ARG("relabelEdges", "edges", edges.size());
+    for (auto& edge : edges)
+    {
+        edge.first = permutation[edge.first];
+        edge.second = permutation[edge.second];
+    }
+}
+
+// Writes numCopies randomly relabeled copies of `edges` back to back into `copies`, and the
+// permutation used for copy k into permutations[k * numVertices ..]. Both buffers are
+// resized rather than reallocated, so a caller that keeps them around pays no allocation
+// per batch. Edge order is preserved, so edge i of a copy is the image of edges[i].
+inline void generateIsomorphicCopies(const vector<pair<int, int>>& edges, int numVertices, int numCopies, mt19937& gen,
+    vector<pair<int, int>>& copies, vector<int>& permutations)
+{
+    TRACE_SCOPE_ARG("generateIsomorphicCopies", "copies", numCopies);
+    copies.resize((size_t)numCopies * edges.size());
+    permutations.resize((size_t)numCopies * numVertices);
+    for (int k = 0; k < numCopies; ++k)
+    {
+        int* permutation = permutations.data() + (size_t)k * numVertices;
+        iota(permutation, permutation + numVertices, 0);
+        shuffle(permutation, permutation + numVertices, gen);
+
+        pair<int, int>* copy = copies.data() + (size_t)k * edges.size();
+        for (size_t e = 0; e < edges.size(); ++e)
+            copy[e] = { permutation[edges[e].first], permutation[edges[e].second] };
+    }
+}
+
+// Function to shuffle vertices randomly while preserving the number of edges
+inline void shuffleVerticesWithSameEdges(BitGraph& graph, mt19937& gen)
+{
+    TRACE_SCOPE_ARG("shuffleVerticesWithSameEdges", "vertices", graph.numVertices);
+    int numVertices = graph.numVertices;
+
+    // Create a random permutation of indices
+    vector<int> permutation;
+    randomPermutation(permutation, numVertices, gen);
+
+    vector<int> inverse(numVertices);
+    for (int i = 0; i < numVertices; ++i)
+    {
+        inverse[permutation[i]] = i;
+    }
+
+    // Row i of the shuffled graph is row permutation[i] of the original with its columns
+    // relabeled, so only set bits are visited.
+    BitGraph shuffled(numVertices);
+    for (int i = 0; i < numVertices; ++i)
+    {
+        uint64_t* target = shuffled.row(i);
+        forEachNeighbor(graph, permutation[i], [&](int u) {
+            target[inverse[u] >> 6] |= uint64_t(1) << (inverse[u] & 63);
+            });
+    }
+
+    graph = std::move(shuffled);
+}
+
+// Shuffles the vertex labels of a sparse graph in O(V + E).
+inline void shuffleVerticesWithSameEdges(CsrGraph& graph, mt19937& gen)
+{
+    TRACE_SCOPE_ARG("shuffleVerticesWithSameEdges", "vertices", graph.numVertices);
+    vector<int> permutation;
+    randomPermutation(permutation, graph.numVertices, gen);
+    graph = relabelVertices(graph, permutation);
+}
+
+inline vector<int> calculateDegrees(const CsrGraph& graph) {
+    vector<int> degrees(graph.numVertices, 0);
+
+    for (int i = 0; i < graph.numVertices; ++i) {
+        degrees[i] = graph.degree(i);
+    }
+
+    return degrees;
+}
+
+inline vector<int> calculateDegrees(const BitGraph& graph) {
+    vector<int> degrees(graph.numVertices, 0);
+
+    for (int i = 0; i < graph.numVertices; ++i) {
+        degrees[i] = graph.degree(i);
+    }
+
+    return degrees;
+}
+
+inline vector<int> calculateDegrees(const vector<vector<int>>& adjacencyMatrix) {
+    int numVertices = adjacencyMatrix.size();
+    vector<int> degrees(numVertices, 0);
+
+    for (int i = 0; i < numVertices; ++i) {
+        for (int j = 0; j < numVertices; ++j) {
+            degrees[i] += adjacencyMatrix[i][j];
+        }
+    }
+
+    return degrees;
+}
+inline bool haveSameDegreeSequence(const vector<int>& degrees1, const vector<int>& degrees2) {
+    if (degrees1.size() != degrees2.size()) {
+        return false;
+    }
+
+    vector<int> sortedDegrees1 = degrees1;
+    vector<int> sortedDegrees2 = degrees2;
+    sort(sortedDegrees1.begin(), sortedDegrees1.end());
+    sort(sortedDegrees2.begin(), sortedDegrees2.end());
+
+    return sortedDegrees1 == sortedDegrees2;
+}
+
+// Adjacency lists with edge multiplicities. Loops are kept apart as a per-vertex count
+// so they can seed the initial coloring instead of being treated as neighbors.
+struct IsoGraph
+{
+    int numVertices = 0;
+    vector<vector<pair<int, int>>> neighbors; // (vertex, multiplicity)
+    vector<int> loops;
+};
+
+inline IsoGraph toIsoGraph(const vector<vector<int>>& adjacencyMatrix)
+{
+    int n = adjacencyMatrix.size();
+    IsoGraph graph;
+    graph.numVertices = n;
+    graph.neighbors.resize(n);
+    graph.loops.assign(n, 0);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            if (adjacencyMatrix[i][j] == 0)
+                continue;
+            if (i == j)
+                graph.loops[i] = adjacencyMatrix[i][j];
+            else
+                graph.neighbors[i].emplace_back(j, adjacencyMatrix[i][j]);
+        }
+    }
+    return graph;
+}
+
+inline IsoGraph toIsoGraph(const BitGraph& bitGraph)
+{
+    IsoGraph graph;
+    graph.numVertices = bitGraph.numVertices;
+    graph.neighbors.resize(bitGraph.numVertices);
+    graph.loops.assign(bitGraph.numVertices, 0);
+    for (int i = 0; i < bitGraph.numVertices; ++i)
+    {
+        graph.neighbors[i].reserve(bitGraph.degree(i));
+        forEachNeighbor(bitGraph, i, [&](int u) { graph.neighbors[i].emplace_back(u, 1); });
+    }
+    return graph;
+}
+
+// Repeated neighbor entries become one edge with a multiplicity.
+inline IsoGraph toIsoGraph(const CsrGraph& csrGraph)
+{
+    IsoGraph graph;
+    graph.numVertices = csrGraph.numVertices;
+    graph.neighbors.resize(csrGraph.numVertices);
+    graph.loops.assign(csrGraph.numVertices, 0);
+    for (int i = 0; i < csrGraph.numVertices; ++i)
+    {
+        for (const int* u = csrGraph.begin(i); u != csrGraph.end(i); ++u)
+        {
+            if (*u == i)
+                graph.loops[i]++;
+            else if (!graph.neighbors[i].empty() && graph.neighbors[i].back().first == *u)
+                graph.neighbors[i].back().second++;
+            else
+                graph.neighbors[i].emplace_back(*u, 1);
+        }
+    }
+    return graph;
+}
+
+// Degree as calculateDegrees counts it on an adjacency matrix: multiplicities plus loops.
+inline vector<int> calculateDegrees(const IsoGraph& graph)
+{
+    vector<int> degrees(graph.numVertices, 0);
+    for (int i = 0; i < graph.numVertices; ++i)
+    {
+        degrees[i] = graph.loops[i];
+        for (const auto& edge : graph.neighbors[i])
+            degrees[i] += edge.second;
+    }
+    return degrees;
+}
+
+// Builds the disjoint union of two graphs: vertices of the second graph are shifted by n.
+inline IsoGraph buildUnionGraph(const IsoGraph& graph1, const IsoGraph& graph2)
+{
+    int n = graph1.numVertices;
+    IsoGraph graph;
+    graph.numVertices = 2 * n;
+    graph.neighbors = graph1.neighbors;
+    graph.neighbors.insert(graph.neighbors.end(), graph2.neighbors.begin(), graph2.neighbors.end());
+    for (int i = n; i < 2 * n; ++i)
+    {
+        for (auto& edge : graph.neighbors[i])
+            edge.first += n;
+    }
+    graph.loops = graph1.loops;
+    graph.loops.insert(graph.loops.end(), graph2.loops.begin(), graph2.loops.end());
+    return graph;
+}
+
+// Sorted sizes of the connected components. A cheap invariant that rules out pairs
+// refinement alone cannot split, such as one long cycle against two short ones.
+inline vector<int> componentSizes(const IsoGraph& graph)
+{
+    vector<int> sizes;
+    vector<char> visited(graph.numVertices, 0);
+    vector<int> stack;
+    for (int root = 0; root < graph.numVertices; ++root)
+    {
+        if (visited[root])
+            continue;
+        visited[root] = 1;
+        stack.push_back(root);
+        int size = 0;
+        while (!stack.empty())
+        {
+            int u = stack.back();
+            stack.pop_back();
+            size++;
+            for (const auto& edge : graph.neighbors[u])
+            {
+                if (!visited[edge.first])
+                {
+                    visited[edge.first] = 1;
+                    stack.push_back(edge.first);
+                }
+            }
+        }
+        sizes.push_back(size);
+    }
+    sort(sizes.begin(), sizes.end());
+    return sizes;
+}
+
+// Ordered partition of the vertices of a union graph. A cell is identified by the index
+// where it starts in `elements`; because both graphs live in the same partition, that
+// index is a color the two graphs agree on.
+struct Partition
+{
+    vector<int> elements;  // vertices grouped by cell
+    vector<int> position;  // index of each vertex in elements
+    vector<int> cellStart; // start of the cell containing each vertex
+    vector<int> cellEnd;   // end (exclusive) of the cell starting at each index
+    int numCells = 0;
+};
+
+// Initial partition: one cell per loop count, ordered by that count.
+inline Partition makeInitialPartition(const IsoGraph& graph)
+{
+    int total = graph.numVertices;
+    Partition p;
+    p.elements.resize(total);
+    iota(p.elements.begin(), p.elements.end(), 0);
+    stable_sort(p.elements.begin(), p.elements.end(), [&](int a, int b) {
+        return graph.loops[a] < graph.loops[b];
+        });
+    p.position.resize(total);
+    p.cellStart.resize(total);
+    p.cellEnd.assign(total, 0);
+
+    for (int i = 0; i < total; ++i)
+    {
+        p.position[p.elements[i]] = i;
+        if (i == 0 || graph.loops[p.elements[i]] != graph.loops[p.elements[i - 1]])
+        {
+            p.numCells++;
+            p.cellStart[p.elements[i]] = i;
+        }
+        else
+        {
+            p.cellStart[p.elements[i]] = p.cellStart[p.elements[i - 1]];
+        }
+        p.cellEnd[p.cellStart[p.elements[i]]] = i + 1;
+    }
+    return p;
+}
+
+// Color refinement (1-WL) by splitter queue. Cells are split until every vertex in a cell
+// has the same weighted number of neighbors in every other cell. Each split keeps only the
+// new fragments that are needed as splitters (all but the largest), so a full refinement
+// costs O((V + E) log V). Cells are split and queued in an order that depends only on cell
+// positions and counts, so the result does not depend on how the vertices are numbered.
+// For the union of two graphs (jointGraphs), returns false as soon as a cell holds a
+// different number of vertices from each graph, because no isomorphism can map such a
+// cell onto itself.
+inline bool refinePartition(const IsoGraph& graph, Partition& p, vector<int> splitters, bool jointGraphs = true)
+{
+    int total = graph.numVertices;
+    int n = total / 2;
+    vector<int> count(total, 0);
+    vector<int> touchedInCell(total, 0);
+    vector<char> inQueue(total, 0);
+    vector<int> touchedVertices;
+    vector<int> touchedCells;
+
+    for (int s : splitters)
+        inQueue[s] = 1;
+
+    while (!splitters.empty())
+    {
+        int splitter = splitters.back();
+        splitters.pop_back();
+        inQueue[splitter] = 0;
+
+        touchedVertices.clear();
+        touchedCells.clear();
+        for (int i = splitter; i < p.cellEnd[splitter]; ++i)
+        {
+            for (const auto& edge : graph.neighbors[p.elements[i]])
+            {
+                if (count[edge.first] == 0)
+                    touchedVertices.push_back(edge.first);
+                count[edge.first] += edge.second;
+            }
+        }
+
+        // Move touched vertices to the back of their cells; untouched ones keep count 0.
+        for (int v : touchedVertices)
+        {
+            int cell = p.cellStart[v];
+            if (touchedInCell[cell] == 0)
+                touchedCells.push_back(cell);
+            int target = p.cellEnd[cell] - 1 - touchedInCell[cell]++;
+            int other = p.elements[target];
+            swap(p.elements[p.position[v]], p.elements[target]);
+            p.position[other] = p.position[v];
+            p.position[v] = target;
+        }
+        sort(touchedCells.begin(), touchedCells.end());
+
+        for (int cell : touchedCells)
+        {
+            int end = p.cellEnd[cell];
+            int firstTouched = end - touchedInCell[cell];
+            touchedInCell[cell] = 0;
+            // Splitters are usually small, so every touched vertex tends to have the same
+            // count; only sort when they differ.
+            bool mixedCounts = false;
+            for (int i = firstTouched + 1; i < end && !mixedCounts; ++i)
+                mixedCounts = count[p.elements[i]] != count[p.elements[firstTouched]];
+            if (mixedCounts)
+            {
+                sort(p.elements.begin() + firstTouched, p.elements.begin() + end, [&](int a, int b) {
+                    return count[a] < count[b];
+                    });
+            }
+
+            vector<int> fragments;
+            if (firstTouched > cell)
+                fragments.push_back(cell);
+            for (int i = firstTouched; i < end; ++i)
+            {
+                p.position[p.elements[i]] = i;
+                if (i == firstTouched || count[p.elements[i]] != count[p.elements[i - 1]])
+                    fragments.push_back(i);
+            }
+            if (fragments.size() == 1)
+                continue;
+
+            // The untouched fragment keeps the cell's start, so only touched vertices are
+            // relabeled. It is balanced whenever the parent and the touched fragments are.
+            int largest = -1;
+            int largestSize = 0;
+            for (size_t f = 0; f < fragments.size(); ++f)
+            {
+                int start = fragments[f];
+                int stop = f + 1 < fragments.size() ? fragments[f + 1] : end;
+                p.cellEnd[start] = stop;
+                if (start >= firstTouched)
+                {
+                    int fromFirstGraph = 0;
+                    for (int i = start; i < stop; ++i)
+                    {
+                        p.cellStart[p.elements[i]] = start;
+                        if (p.elements[i] < n)
+                            fromFirstGraph++;
+                    }
+                    if (jointGraphs && 2 * fromFirstGraph != stop - start)
+                    {
+                        for (int v : touchedVertices)
+                            count[v] = 0;
+                        return false;
+                    }
+                }
+                if (stop - start > largestSize)
+                {
+                    largestSize = stop - start;
+                    largest = start;
+                }
+            }
+            p.numCells += fragments.size() - 1;
+
+            bool parentQueued = inQueue[cell];
+            for (int start : fragments)
+            {
+                if (inQueue[start] || (!parentQueued && start == largest))
+                    continue;
+                inQueue[start] = 1;
+                splitters.push_back(start);
+            }
+        }
+
+        for (int v : touchedVertices)
+            count[v] = 0;
+    }
+    return true;
+}
+
+// Gives vertex v (first graph) and w (second graph) a cell of their own at the front of
+// the cell they share, and refines from there.
+inline bool individualize(const IsoGraph& graph, Partition& p, int v, int w)
+{
+    int cell = p.cellStart[v];
+    int end = p.cellEnd[cell];
+    int targets[2] = { v, w };
+    for (int k = 0; k < 2; ++k)
+    {
+        int u = targets[k];
+        int other = p.elements[cell + k];
+        swap(p.elements[p.position[u]], p.elements[cell + k]);
+        p.position[other] = p.position[u];
+        p.position[u] = cell + k;
+    }
+    for (int i = cell + 2; i < end; ++i)
+        p.cellStart[p.elements[i]] = cell + 2;
+    p.cellEnd[cell] = cell + 2;
+    p.cellEnd[cell + 2] = end;
+    p.numCells++;
+    return refinePartition(graph, p, { cell, cell + 2 });
+}
+
+struct AutomorphismGroup;
+inline AutomorphismGroup automorphismGroup(const IsoGraph& graph);
+
+// Automorphisms of the second graph, for orbit pruning in searchIsomorphism: if mapping v
+// to w fails, so does mapping v to any w' that an automorphism fixing the graph-2 vertices
+// already individualized takes w to. The group is computed the first time a branch fails,
+// so searches that never backtrack do not pay for it.
+struct SearchSymmetry
+{
+    const IsoGraph& graph2;
+    unique_ptr<AutomorphismGroup> group;
+    vector<char> fixed; // graph-2 vertices individualized on the current path
+
+    explicit SearchSymmetry(const IsoGraph& graph2) : graph2(graph2), fixed(graph2.numVertices, 0) {}
+
+    void compute();
+    vector<int> orbits() const;
+};
+
+// Individualization-refinement search. Once every cell holds exactly one vertex from each
+// graph the partition is discrete, and because it is equitable the pairing is an isomorphism.
+// Vertices of graph 2 in the same orbit as one that already failed are skipped.
+inline bool searchIsomorphism(const IsoGraph& graph, const Partition& p, vector<int>& mapping, SearchSymmetry& symmetry, int depth = 0)
+{
+    TRACE_SCOPE_ARG("searchIsomorphism", "depth", depth);
+    int n = graph.numVertices / 2;
+    if (p.numCells == n)
+    {
+        mapping.assign(n, -1);
+        for (int i = 0; i < 2 * n; i += 2)
+        {
+            int a = p.elements[i];
+            int b = p.elements[i + 1];
+            if (a < n)
+                mapping[a] = b - n;
+            else
+                mapping[b] = a - n;
+        }
+        return true;
+    }
+
+    // Branch on the smallest non-trivial cell to keep the search tree narrow.
+    int target = -1;
+    for (int i = 0; i < 2 * n; i = p.cellEnd[i])
+    {
+        int size = p.cellEnd[i] - i;
+        if (size > 2 && (target == -1 || size < p.cellEnd[target] - target))
+            target = i;
+    }
+
+    int v = -1;
+    for (int i = target; v == -1; ++i)
+    {
+        if (p.elements[i] < n)
+            v = p.elements[i];
+    }
+    vector<int> cell(p.elements.begin() + target, p.elements.begin() + p.cellEnd[target]);
+    vector<int> failed;
+    vector<int> orbits;
+    for (int w : cell)
+    {
+        if (w < n)
+            continue;
+        if (!failed.empty())
+        {
+            if (orbits.empty())
+                orbits = symmetry.orbits();
+            bool equivalent = false;
+            for (int u : failed)
+                equivalent = equivalent || orbits[u - n] == orbits[w - n];
+            if (equivalent)
+                continue;
+        }
+        Partition branch = p;
+        symmetry.fixed[w - n] = 1;
+        bool found = individualize(graph, branch, v, w) && searchIsomorphism(graph, branch, mapping, symmetry, depth + 1);
+        symmetry.fixed[w - n] = 0;
+        if (found)
+            return true;
+        TRACE_INSTANT("backtrack", "depth", depth);
+        if (!symmetry.group)
+            symmetry.compute();
+        failed.push_back(w);
+    }
+    return false;
+}
+
+// Exact isomorphism test. Edge multiplicities and loop counts must match as well. On
+// success mapping[v] is the vertex of graph 2 that vertex v of graph 1 maps to.
+inline bool isIsomorphic(const IsoGraph& graph1, const IsoGraph& graph2, vector<int>& mapping)
+{
+    TRACE_SCOPE_ARG("isIsomorphic", "vertices", graph1.numVertices);
+    mapping.clear();
+    int n = graph1.numVertices;
+    if (n != graph2.numVertices)
+        return false;
+    if (!haveSameDegreeSequence(calculateDegrees(graph1), calculateDegrees(graph2)))
+        return false;
+    if (n == 0)
+        return true;
+    if (componentSizes(graph1) != componentSizes(graph2))
+        return false;
+
+    IsoGraph graph = buildUnionGraph(graph1, graph2);
+    Partition p = makeInitialPartition(graph);
+    vector<int> splitters;
+    for (int i = 0; i < graph.numVertices; i = p.cellEnd[i])
+    {
+        int fromFirstGraph = 0;
+        for (int j = i; j < p.cellEnd[i]; ++j)
+            fromFirstGraph += p.elements[j] < n;
+        if (2 * fromFirstGraph != p.cellEnd[i] - i)
+            return false;
+        splitters.push_back(i);
+    }
+    if (!refinePartition(graph, p, splitters))
+        return false;
+    SearchSymmetry symmetry(graph2);
+    return searchIsomorphism(graph, p, mapping, symmetry);
+}
+
+// Adjacency matrices hold edge multiplicities, with loops on the diagonal.
+inline bool isIsomorphic(const vector<vector<int>>& adjacencyMatrix1, const vector<vector<int>>& adjacencyMatrix2, vector<int>& mapping)
+{
+    return isIsomorphic(toIsoGraph(adjacencyMatrix1), toIsoGraph(adjacencyMatrix2), mapping);
+}
+
+// Result of canonical labeling. Two graphs are isomorphic exactly when their certificates
+// are equal; the hash is a 64-bit digest of the certificate for tables and caches.
+struct CanonicalForm
+{
+    vector<int> labeling;    // labeling[v] = canonical label of vertex v
+    vector<int> certificate; // n, then per canonical vertex: loops, entry count, (label, multiplicity)...
+    uint64_t hash = 0;
+    vector<vector<int>> automorphisms; // generators found during the search
+    double automorphismCount = 1;      // group order (exact while it fits in a double)
+};
+
+inline uint64_t hashCertificate(const vector<int>& certificate)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int value : certificate)
+    {
+        hash ^= (uint32_t)value;
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Gives vertex v a cell of its own at the front of its cell and refines from there.
+inline void individualizeVertex(const IsoGraph& graph, Partition& p, int v)
+{
+    int cell = p.cellStart[v];
+    int end = p.cellEnd[cell];
+    int other = p.elements[cell];
+    swap(p.elements[p.position[v]], p.elements[cell]);
+    p.position[other] = p.position[v];
+    p.position[v] = cell;
+    for (int i = cell + 1; i < end; ++i)
+        p.cellStart[p.elements[i]] = cell + 1;
+    p.cellEnd[cell] = cell + 1;
+    p.cellEnd[cell + 1] = end;
+    p.numCells++;
+    refinePartition(graph, p, { cell, cell + 1 }, false);
+}
+
+// Search tree of individualization-refinement on one graph. Every leaf is a discrete
+// partition, i.e. a labeling; the canonical one is the leaf with the smallest certificate.
+// Leaves with equal certificates differ by an automorphism, which is recorded and used two
+// ways: the rest of the equivalent subtree is abandoned (we jump back to where the two
+// paths diverge), and children in the same orbit of the automorphisms fixing the current
+// path are skipped. Orbit sizes along the first path multiply to the group order.
+struct CanonicalSearch
+{
+    const IsoGraph& graph;
+    vector<int> path;
+    vector<int> firstPath, bestPath;
+    vector<int> firstElements, bestElements;
+    vector<int> firstCertificate, bestCertificate;
+    vector<vector<int>> automorphisms;
+    vector<vector<int>> supports; // vertices each automorphism moves
+    vector<char> inPath;
+    double groupOrder = 1;
+
+    explicit CanonicalSearch(const IsoGraph& g) : graph(g), inPath(g.numVertices, 0) {}
+
+    vector<int> certificateOf(const Partition& p) const
+    {
+        int n = graph.numVertices;
+        vector<int> certificate;
+        certificate.reserve(1 + 2 * n + 2 * (size_t)n);
+        certificate.push_back(n);
+        vector<pair<int, int>> row;
+        for (int label = 0; label < n; ++label)
+        {
+            int v = p.elements[label];
+            row.clear();
+            for (const auto& edge : graph.neighbors[v])
+                row.emplace_back(p.position[edge.first], edge.second);
+            sort(row.begin(), row.end());
+            certificate.push_back(graph.loops[v]);
+            certificate.push_back(row.size());
+            for (const auto& entry : row)
+            {
+                certificate.push_back(entry.first);
+                certificate.push_back(entry.second);
+            }
+        }
+        return certificate;
+    }
+
+    // Orbits (as union-find roots) of the recorded automorphisms that fix the path.
+    vector<int> orbitsFixingPath() const
+    {
+        int n = graph.numVertices;
+        vector<int> parent(n);
+        iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int x) {
+            while (parent[x] != x)
+                x = parent[x] = parent[parent[x]];
+            return x;
+            };
+        for (size_t k = 0; k < automorphisms.size(); ++k)
+        {
+            bool fixesPath = true;
+            for (int v : supports[k])
+                fixesPath = fixesPath && !inPath[v];
+            if (!fixesPath)
+                continue;
+            for (int v : supports[k])
+            {
+                int a = find(v), b = find(automorphisms[k][v]);
+                if (a != b)
+                    parent[max(a, b)] = min(a, b);
+            }
+        }
+        for (int v = 0; v < n; ++v)
+            find(v);
+        return parent;
+    }
+
+    static int divergence(const vector<int>& path1, const vector<int>& path2)
+    {
+        int depth = 0;
+        while (depth < (int)path1.size() && depth < (int)path2.size() && path1[depth] == path2[depth])
+            ++depth;
+        return depth;
+    }
+
+    void recordAutomorphism(const vector<int>& fromElements, const Partition& p)
+    {
+        vector<int> automorphism(graph.numVertices);
+        vector<int> support;
+        for (int i = 0; i < graph.numVertices; ++i)
+        {
+            automorphism[fromElements[i]] = p.elements[i];
+            if (fromElements[i] != p.elements[i])
+                support.push_back(fromElements[i]);
+        }
+        automorphisms.push_back(std::move(automorphism));
+        supports.push_back(std::move(support));
+    }
+
+    // Returns the depth the search should unwind to, or -1 to carry on normally.
+    int search(const Partition& p, bool onFirstPath)
+    {
+        int n = graph.numVertices;
+        int depth = path.size();
+        if (p.numCells == n)
+        {
+            vector<int> certificate = certificateOf(p);
+            if (firstElements.empty())
+            {
+                firstPath = bestPath = path;
+                firstElements = bestElements = p.elements;
+                firstCertificate = bestCertificate = certificate;
+                return -1;
+            }
+            if (certificate == firstCertificate)
+            {
+                recordAutomorphism(firstElements, p);
+                return divergence(path, firstPath);
+            }
+            if (certificate == bestCertificate)
+            {
+                recordAutomorphism(bestElements, p);
+                return divergence(path, bestPath);
+            }
+            if (certificate < bestCertificate)
+            {
+                bestPath = path;
+                bestElements = p.elements;
+                bestCertificate = std::move(certificate);
+            }
+            return -1;
+        }
+
+        int target = -1;
+        for (int i = 0; i < n; i = p.cellEnd[i])
+        {
+            int size = p.cellEnd[i] - i;
+            if (size > 1 && (target == -1 || size < p.cellEnd[target] - target))
+                target = i;
+        }
+
+        vector<int> explored;
+        vector<int> orbits;
+        size_t orbitsFrom = (size_t)-1;
+        vector<int> cell(p.elements.begin() + target, p.elements.begin() + p.cellEnd[target]);
+        for (size_t k = 0; k < cell.size(); ++k)
+        {
+            int v = cell[k];
+            if (!automorphisms.empty())
+            {
+                if (orbitsFrom != automorphisms.size())
+                {
+                    orbits = orbitsFixingPath();
+                    orbitsFrom = automorphisms.size();
+                }
+                bool equivalent = false;
+                for (int u : explored)
+                    equivalent = equivalent || orbits[u] == orbits[v];
+                if (equivalent)
+                    continue;
+            }
+            explored.push_back(v);
+
+            Partition child = p;
+            individualizeVertex(graph, child, v);
+            path.push_back(v);
+            inPath[v] = 1;
+            int unwindTo = search(child, onFirstPath && k == 0);
+            inPath[v] = 0;
+            path.pop_back();
+            if (unwindTo != -1 && unwindTo < depth)
+                return unwindTo;
+        }
+
+        if (onFirstPath)
+        {
+            orbits = orbitsFixingPath();
+            int orbitSize = 0;
+            for (int v : cell)
+                orbitSize += orbits[v] == orbits[cell[0]];
+            groupOrder *= orbitSize;
+        }
+        return -1;
+    }
+};
+
+inline CanonicalForm canonicalForm(const IsoGraph& graph)
+{
+    TRACE_SCOPE_ARG("canonicalForm", "vertices", graph.numVertices);
+    CanonicalForm form;
+    int n = graph.numVertices;
+    Partition p = makeInitialPartition(graph);
+    if (n > 0)
+    {
+        vector<int> splitters;
+        for (int i = 0; i < n; i = p.cellEnd[i])
+            splitters.push_back(i);
+        refinePartition(graph, p, splitters, false);
+    }
+
+    CanonicalSearch search(graph);
+    search.search(p, true);
+    form.certificate = std::move(search.bestCertificate);
+    if (n == 0)
+        form.certificate = { 0 };
+    form.labeling.resize(n);
+    for (int i = 0; i < n; ++i)
+        form.labeling[search.bestElements[i]] = i;
+    form.hash = hashCertificate(form.certificate);
+    form.automorphisms = std::move(search.automorphisms);
+    form.automorphismCount = search.groupOrder;
+    return form;
+}
+
+// Automorphism group of a graph: generators, vertex orbits and the group order. The group of
+// a disjoint union is generated by the groups of its connected components and by swaps of
+// isomorphic components, so it is kept in that form.
+struct AutomorphismGroup
+{
+    vector<vector<int>> generators; // generators[k][v] = image of v
+    vector<int> orbits;             // orbits[v] = smallest vertex in the orbit of v
+    double order = 1;               // exact while it fits in a double
+
+    vector<int> component;               // component of each vertex
+    vector<int> componentClass;          // components with equal classes are isomorphic
+    vector<vector<int>> byLabel;         // byLabel[c][label] = vertex of component c
+    vector<vector<int>> localGenerators; // generators acting inside each component
+
+    bool equivalent(int v1, int v2) const { return orbits[v1] == orbits[v2]; }
+
+    // Orbits (smallest vertex of each) of automorphisms that fix every vertex marked in
+    // `fixed`. Components without fixed vertices may still be swapped with each other; inside
+    // a component only the generators that fix its marked vertices are used, which can give
+    // finer orbits than the full stabilizer but never wrong ones.
+    vector<int> orbitsFixing(const vector<char>& fixed) const
+    {
+        int n = component.size();
+        vector<int> parent(n);
+        iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int x) {
+            while (parent[x] != x)
+                x = parent[x] = parent[parent[x]];
+            return x;
+            };
+        auto unite = [&](int a, int b) {
+            a = find(a);
+            b = find(b);
+            if (a != b)
+                parent[max(a, b)] = min(a, b);
+            };
+        vector<char> touched(byLabel.size(), 0);
+        for (int v = 0; v < n; ++v)
+        {
+            if (fixed[v])
+                touched[component[v]] = 1;
+        }
+        map<int, int> representative; // class -> first untouched component
+        for (size_t c = 0; c < byLabel.size(); ++c)
+        {
+            const vector<int>& vertices = byLabel[c];
+            for (int k : localGenerators[c])
+            {
+                bool fixesAll = true;
+                for (int v : vertices)
+                    fixesAll = fixesAll && (!fixed[v] || generators[k][v] == v);
+                if (fixesAll)
+                {
+                    for (int v : vertices)
+                        unite(v, generators[k][v]);
+                }
+            }
+            if (touched[c])
+                continue;
+            auto it = representative.emplace(componentClass[c], (int)c).first;
+            if (it->second != (int)c)
+            {
+                for (size_t label = 0; label < vertices.size(); ++label)
+                    unite(vertices[label], byLabel[it->second][label]);
+            }
+        }
+        for (int v = 0; v < n; ++v)
+            find(v);
+        return parent;
+    }
+};
+
+// Each connected component goes through the canonical search on its own, which spares the
+// search a tree over every order of equal components (k equal components have k! orders).
+inline AutomorphismGroup automorphismGroup(const IsoGraph& graph)
+{
+    TRACE_SCOPE_ARG("automorphismGroup", "vertices", graph.numVertices);
+    int n = graph.numVertices;
+    AutomorphismGroup group;
+    group.component.assign(n, -1);
+    vector<vector<int>> members; // vertices of each component, in increasing order
+    for (int root = 0; root < n; ++root)
+    {
+        if (group.component[root] != -1)
+            continue;
+        int id = members.size();
+        members.emplace_back(1, root);
+        group.component[root] = id;
+        for (size_t i = 0; i < members[id].size(); ++i)
+        {
+            for (const auto& edge : graph.neighbors[members[id][i]])
+            {
+                if (group.component[edge.first] == -1)
+                {
+                    group.component[edge.first] = id;
+                    members[id].push_back(edge.first);
+                }
+            }
+        }
+        sort(members[id].begin(), members[id].end());
+    }
+
+    int numComponents = members.size();
+    vector<int> local(n);
+    vector<int> identity(n);
+    iota(identity.begin(), identity.end(), 0);
+    map<vector<int>, vector<int>> isomorphic; // certificate -> components with it
+    group.byLabel.resize(numComponents);
+    group.localGenerators.resize(numComponents);
+    group.componentClass.resize(numComponents);
+    for (int c = 0; c < numComponents; ++c)
+    {
+        const vector<int>& vertices = members[c];
+        for (size_t i = 0; i < vertices.size(); ++i)
+            local[vertices[i]] = i;
+        IsoGraph part;
+        part.numVertices = vertices.size();
+        part.neighbors.resize(vertices.size());
+        part.loops.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            part.loops[i] = graph.loops[vertices[i]];
+            for (const auto& edge : graph.neighbors[vertices[i]])
+                part.neighbors[i].emplace_back(local[edge.first], edge.second);
+        }
+        CanonicalForm form = canonicalForm(part);
+        group.order *= form.automorphismCount;
+        for (const auto& automorphism : form.automorphisms)
+        {
+            vector<int> generator = identity;
+            for (size_t i = 0; i < vertices.size(); ++i)
+                generator[vertices[i]] = vertices[automorphism[i]];
+            group.localGenerators[c].push_back(group.generators.size());
+            group.generators.push_back(std::move(generator));
+        }
+        group.byLabel[c].resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+            group.byLabel[c][form.labeling[i]] = vertices[i];
+        isomorphic[form.certificate].push_back(c);
+    }
+    int numClasses = 0;
+    for (const auto& entry : isomorphic)
+    {
+        const vector<int>& equal = entry.second;
+        for (size_t k = 0; k < equal.size(); ++k)
+        {
+            group.componentClass[equal[k]] = numClasses;
+            if (k == 0)
+                continue;
+            // Swap two consecutive equal components along their canonical labelings
+            vector<int> generator = identity;
+            const vector<int>& a = group.byLabel[equal[k - 1]];
+            const vector<int>& b = group.byLabel[equal[k]];
+            for (size_t label = 0; label < a.size(); ++label)
+            {
+                generator[a[label]] = b[label];
+                generator[b[label]] = a[label];
+            }
+            group.generators.push_back(std::move(generator));
+            group.order *= k + 1;
+        }
+        ++numClasses;
+    }
+    group.orbits = group.orbitsFixing(vector<char>(n, 0));
+    return group;
+}
+
+inline AutomorphismGroup automorphismGroup(const CsrGraph& graph)
+{
+    return automorphismGroup(toIsoGraph(graph));
+}
+
+inline void SearchSymmetry::compute()
+{
+    group.reset(new AutomorphismGroup(automorphismGroup(graph2)));
+}
+
+inline vector<int> SearchSymmetry::orbits() const
+{
+    return group->orbitsFixing(fixed);
+}
+
+inline CanonicalForm canonicalForm(const CsrGraph& graph)
+{
+    return canonicalForm(toIsoGraph(graph));
+}
+
+inline CanonicalForm canonicalForm(const vector<vector<int>>& adjacencyMatrix)
+{
+    return canonicalForm(toIsoGraph(adjacencyMatrix));
+}
+
+// What the cache remembers about an isomorphism class.
+struct GraphInfo
+{
+    vector<int> certificate;
+    double automorphismCount = 1;
+    vector<int> degreeSequence; // sorted
+    vector<int> componentSizes; // sorted
+    int numEdges = 0;
+};
+
+inline GraphInfo describeGraph(const IsoGraph& graph, const CanonicalForm& form)
+{
+    GraphInfo info;
+    info.certificate = form.certificate;
+    info.automorphismCount = form.automorphismCount;
+    info.degreeSequence = calculateDegrees(graph);
+    sort(info.degreeSequence.begin(), info.degreeSequence.end());
+    info.componentSizes = componentSizes(graph);
+    for (int v = 0; v < graph.numVertices; ++v)
+    {
+        info.numEdges += graph.loops[v];
+        for (const auto& edge : graph.neighbors[v])
+            info.numEdges += v < edge.first ? edge.second : 0;
+    }
+    return info;
+}
+
+// Thread-safe LRU cache from canonical hash to GraphInfo. Keys are spread over shards that
+// each have their own lock and recency list, so concurrent workers rarely contend. The
+// stored certificate is compared on lookup, so a hash collision reads as a miss.
+class GraphCache
+{
+public:
+    explicit GraphCache(size_t capacity, int numShards = 16)
+        : shards(max(1, numShards)), shardCapacity(max<size_t>(1, capacity / max(1, numShards))) {}
+
+    bool lookup(uint64_t hash, const vector<int>& certificate, GraphInfo& info)
+    {
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.index.find(hash);
+        if (it == shard.index.end() || it->second->second.certificate != certificate)
+            return false;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        info = it->second->second;
+        return true;
+    }
+
+    // Inserts or refreshes an entry. Returns false if the class was already cached.
+    bool insert(uint64_t hash, GraphInfo info)
+    {
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.index.find(hash);
+        if (it != shard.index.end())
+        {
+            bool same = it->second->second.certificate == info.certificate;
+            it->second->second = std::move(info);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return !same;
+        }
+        shard.entries.emplace_front(hash, std::move(info));
+        shard.index[hash] = shard.entries.begin();
+        if (shard.entries.size() > shardCapacity)
+        {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        return true;
+    }
+
+    size_t size()
+    {
+        size_t total = 0;
+        for (auto& shard : shards)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+
+private:
+    struct Shard
+    {
+        mutex lock;
+        list<pair<uint64_t, GraphInfo>> entries; // most recently used first
+        unordered_map<uint64_t, list<pair<uint64_t, GraphInfo>>::iterator> index;
+    };
+
+    Shard& shardFor(uint64_t hash) { return shards[(hash >> 48) % shards.size()]; }
+
+    vector<Shard> shards;
+    size_t shardCapacity;
+};
+
+// Canonicalizes a graph and returns what the cache knows about its isomorphism class,
+// computing and inserting it on a miss. `isNew` reports whether the class was unseen,
+// which is how generators reject duplicate puzzles.
+inline GraphInfo analyzeGraph(const IsoGraph& graph, GraphCache& cache, CanonicalForm& form, bool& isNew)
+{
+    form = canonicalForm(graph);
+    GraphInfo info;
+    isNew = !cache.lookup(form.hash, form.certificate, info);
+    if (isNew)
+    {
+        info = describeGraph(graph, form);
+        cache.insert(form.hash, info);
+    }
+    return info;
+}
+
+// Popcount usable in constant expressions. GCC and Clang's builtin is one, but it is only
+// a single instruction when POPCNT is enabled; otherwise the SWAR version is faster.
+constexpr int smallPopcount(uint64_t word)
+{
+#if defined(__GNUC__) && defined(__POPCNT__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+constexpr int smallLowestBit(uint64_t word)
+{
+    return smallPopcount((word & (~word + 1)) - 1);
+}
+
+// Simple graph (loops allowed, no parallel edges) with at most N <= 64 vertices, one
+// 64-bit row per vertex and no heap storage. N is the compile-time bound used to size
+// every array, so loops over it can be unrolled and the whole type works in constant
+// expressions. The dense and CSR graphs remain the representation for larger inputs.
+template <int N>
+struct SmallGraph
+{
+    static_assert(N > 0 && N <= 64, "SmallGraph stores one 64-bit row per vertex");
+
+    int numVertices = 0;
+    uint64_t rows[N] = {};
+
+    constexpr SmallGraph() = default;
+    constexpr explicit SmallGraph(int vertices) : numVertices(vertices) {}
+
+    constexpr bool hasEdge(int v1, int v2) const { return (rows[v1] >> v2) & 1; }
+    constexpr void addEdge(int v1, int v2)
+    {
+        rows[v1] |= uint64_t(1) << v2;
+        rows[v2] |= uint64_t(1) << v1;
+    }
+    constexpr int degree(int v) const { return smallPopcount(rows[v]); }
+};
+
+template <int N>
+constexpr void calculateDegrees(const SmallGraph<N>& graph, int (&degrees)[N])
+{
+    for (int v = 0; v < N; ++v)
+        degrees[v] = v < graph.numVertices ? graph.degree(v) : 0;
+}
+
+// Vertex v of `graph` becomes permutation[v].
+template <int N>
+constexpr SmallGraph<N> permuteSmallGraph(const SmallGraph<N>& graph, const int (&permutation)[N])
+{
+    SmallGraph<N> permuted(graph.numVertices);
+    for (int v = 0; v < graph.numVertices; ++v)
+    {
+        uint64_t row = 0;
+        for (uint64_t bits = graph.rows[v]; bits != 0; bits &= bits - 1)
+            row |= uint64_t(1) << permutation[smallLowestBit(bits)];
+        permuted.rows[permutation[v]] = row;
+    }
+    return permuted;
+}
+
+// Exact isomorphism test on two small graphs. Color refinement runs jointly on both graphs
+// using popcounts of rows against color-class masks, then a depth-first search assigns
+// vertices of graph 1 in a fixed order. The candidates for each vertex are one mask: same
+// color, unused, and adjacent exactly to the images of its already mapped neighbors.
+// Returns 1 if isomorphic, 0 if not, and -1 if the search tried more than `budget`
+// candidates (a negative budget never runs out).
+template <int N>
+constexpr int searchSmallIsomorphism(const SmallGraph<N>& graph1, const SmallGraph<N>& graph2, int (&mapping)[N], long long budget)
+{
+    const int n = graph1.numVertices;
+    if (n != graph2.numVertices)
+        return 0;
+    const SmallGraph<N>* graphs[2] = { &graph1, &graph2 };
+
+    // Joint color refinement. A signature is the old color plus the number of neighbors in
+    // each old color class, and the new color is the signature's hash. A hash collision can
+    // only merge classes, which weakens pruning but never correctness: colors stay an
+    // isomorphism invariant and the search checks every adjacency it commits to.
+    int color[2][N] = {};
+    int numColors = 1;
+    for (int g = 0; g < 2; ++g)
+    {
+        for (int v = 0; v < n; ++v)
+        {
+            color[g][v] = graphs[g]->hasEdge(v, v) ? 1 : 0;
+            numColors = color[g][v] + 1 > numColors ? color[g][v] + 1 : numColors;
+        }
+    }
+    while (true)
+    {
+        uint64_t classMask[2][N] = {};
+        for (int g = 0; g < 2; ++g)
+        {
+            for (int v = 0; v < n; ++v)
+                classMask[g][color[g][v]] |= uint64_t(1) << v;
+        }
+
+        uint64_t hash[2][N] = {};
+        for (int g = 0; g < 2; ++g)
+        {
+            for (int v = 0; v < n; ++v)
+            {
+                uint64_t h = (uint64_t)color[g][v] * 0x9e3779b97f4a7c15ULL;
+                for (int k = 0; k < numColors; ++k)
+                    h = (h ^ (uint64_t)smallPopcount(graphs[g]->rows[v] & classMask[g][k])) * 0x100000001b3ULL;
+                hash[g][v] = h;
+            }
+        }
+
+        int newColor[2][N] = {};
+        uint64_t colorHash[N] = {};
+        int numNewColors = 0;
+        for (int g = 0; g < 2; ++g)
+        {
+            for (int v = 0; v < n; ++v)
+            {
+                int found = -1;
+                for (int c = 0; c < numNewColors && found == -1; ++c)
+                {
+                    if (colorHash[c] == hash[g][v])
+                        found = c;
+                }
+                if (found == -1)
+                {
+                    if (numNewColors == N)
+                        return 0;
+                    found = numNewColors++;
+                    colorHash[found] = hash[g][v];
+                }
+                newColor[g][v] = found;
+            }
+        }
+
+        int balance[N] = {};
+        for (int v = 0; v < n; ++v)
+        {
+            balance[newColor[0][v]]++;
+            balance[newColor[1][v]]--;
+        }
+        for (int c = 0; c < numNewColors; ++c)
+        {
+            if (balance[c] != 0)
+                return 0;
+        }
+
+        for (int g = 0; g < 2; ++g)
+        {
+            for (int v = 0; v < n; ++v)
+                color[g][v] = newColor[g][v];
+        }
+        if (numNewColors <= numColors)
+            break;
+        numColors = numNewColors;
+    }
+
+    uint64_t colorMask2[N] = {};
+    for (int v = 0; v < n; ++v)
+        colorMask2[color[1][v]] |= uint64_t(1) << v;
+
+    // Search order: always take the unplaced vertex with the most placed neighbors, so the
+    // adjacency constraints bite as early as possible.
+    int order[N] = {};
+    uint64_t placed = 0;
+    for (int k = 0; k < n; ++k)
+    {
+        int best = -1;
+        int bestLinks = -1;
+        for (int v = 0; v < n; ++v)
+        {
+            if ((placed >> v) & 1)
+                continue;
+            int links = smallPopcount(graph1.rows[v] & placed);
+            if (links > bestLinks)
+            {
+                best = v;
+                bestLinks = links;
+            }
+        }
+        order[k] = best;
+        placed |= uint64_t(1) << best;
+    }
+
+    uint64_t candidates[N] = {};
+    int chosen[N] = {};
+    uint64_t used = 0;
+    int depth = 0;
+    bool startLevel = true;
+    long long tried = 0;
+    while (depth >= 0)
+    {
+        if (depth == n)
+            return 1;
+        int v = order[depth];
+        if (startLevel)
+        {
+            uint64_t mask = colorMask2[color[0][v]] & ~used;
+            for (int k = 0; k < depth; ++k)
+            {
+                int u = order[k];
+                mask &= graph1.hasEdge(v, u) ? graph2.rows[mapping[u]] : ~graph2.rows[mapping[u]];
+            }
+            candidates[depth] = mask;
+            chosen[depth] = -1;
+            startLevel = false;
+        }
+        if (chosen[depth] != -1)
+            used &= ~(uint64_t(1) << chosen[depth]);
+        if (candidates[depth] == 0)
+        {
+            --depth;
+            continue;
+        }
+        if (budget >= 0 && ++tried > budget)
+            return -1;
+        int w = smallLowestBit(candidates[depth]);
+        candidates[depth] &= candidates[depth] - 1;
+        chosen[depth] = w;
+        mapping[v] = w;
+        used |= uint64_t(1) << w;
+        ++depth;
+        startLevel = true;
+    }
+    return 0;
+}
+
+template <int N>
+constexpr bool isIsomorphic(const SmallGraph<N>& graph1, const SmallGraph<N>& graph2, int (&mapping)[N])
+{
+    return searchSmallIsomorphism(graph1, graph2, mapping, -1) == 1;
+}
+
+template <int N>
+SmallGraph<N> toSmallGraph(const CsrGraph& csrGraph)
+{
+    SmallGraph<N> graph(csrGraph.numVertices);
+    for (int v = 0; v < csrGraph.numVertices; ++v)
+    {
+        for (const int* u = csrGraph.begin(v); u != csrGraph.end(v); ++u)
+            graph.rows[v] |= uint64_t(1) << *u;
+    }
+    return graph;
+}
+
+// True if no neighbor list has a repeated entry, i.e. the graph fits a SmallGraph.
+inline bool hasParallelEdges(const CsrGraph& graph)
+{
+    for (int v = 0; v < graph.numVertices; ++v)
+    {
+        if (adjacent_find(graph.begin(v), graph.end(v)) != graph.end(v))
+            return true;
+    }
+    return false;
+}
+
+// The mask search has no symmetry pruning, so on graphs with many automorphisms that it
+// cannot tell apart (unions of equal components, for one) it can backtrack for a factorial
+// time. Past a budget the pair goes to the general engine, which prunes by orbits.
+template <int N>
+bool isIsomorphicSmall(const CsrGraph& graph1, const CsrGraph& graph2, vector<int>& mapping)
+{
+    TRACE_SCOPE_ARG("isIsomorphicSmall", "vertices", graph1.numVertices);
+    int smallMapping[N] = {};
+    int result = searchSmallIsomorphism(toSmallGraph<N>(graph1), toSmallGraph<N>(graph2), smallMapping, 64LL * N * N);
+    if (result == -1)
+    {
+        TRACE_INSTANT("small search over budget", "vertices", graph1.numVertices);
+        return isIsomorphic(toIsoGraph(graph1), toIsoGraph(graph2), mapping);
+    }
+    if (result == 0)
+    {
+        mapping.clear();
+        return false;
+    }
+    mapping.assign(smallMapping, smallMapping + graph1.numVertices);
+    return true;
+}
+
+// Dispatches simple graphs that fit a board to the compile-time kernels and everything
+// else (multigraphs, more than 64 vertices) to the general engine.
+inline bool isIsomorphic(const CsrGraph& graph1, const CsrGraph& graph2, vector<int>& mapping)
+{
+    if (graph1.numVertices != graph2.numVertices || graph1.neighbors.size() != graph2.neighbors.size())
+    {
+        mapping.clear();
+        return false;
+    }
+    if (graph1.numVertices <= 64 && !hasParallelEdges(graph1) && !hasParallelEdges(graph2))
+    {
+        if (graph1.numVertices <= 16)
+            return isIsomorphicSmall<16>(graph1, graph2, mapping);
+        return isIsomorphicSmall<64>(graph1, graph2, mapping);
+    }
+    return isIsomorphic(toIsoGraph(graph1), toIsoGraph(graph2), mapping);
+}
+
+// Graphs with exactly the same degree sequence, loops and vertex count as `edges` that are
+// not isomorphic to it: "looks the same but isn't" puzzles. Each candidate applies one
+// double-edge swap at a time and stops as soon as the exact check says it differs, so
+// distractors stay as close to the original as possible. Candidates are built and verified
+// on numThreads workers (all cores when 0). Every candidate slot has its own generator
+// derived from `seed`, so the result depends only on the input and the seed, whichever
+// worker takes a slot; the results are then deduplicated by canonical form. Graphs whose degree
+// sequence has a single realization yield fewer than numDistractors results.
+inline vector<vector<pair<int, int>>> generateDistractors(int numVertices, const vector<pair<int, int>>& edges,
+    int numDistractors, unsigned seed, int numThreads = 0)
+{
+    TRACE_SCOPE_ARG("generateDistractors", "distractors", numDistractors);
+    if (numThreads <= 0)
+        numThreads = max(1u, thread::hardware_concurrency());
+    numThreads = max(1, min(numThreads, numDistractors));
+    const CsrGraph original = buildCsrGraph(numVertices, edges);
+    const int attemptsPerCandidate = 4;
+    const long long swapBudget = 4 * (long long)edges.size() + 8;
+
+    vector<vector<pair<int, int>>> candidates(numDistractors);
+    vector<char> found(numDistractors, 0);
+    atomic<int> nextSlot(0);
+    auto worker = [&]() {
+        vector<int> mapping;
+        for (int slot = nextSlot++; slot < numDistractors; slot = nextSlot++)
+        {
+            mt19937 gen(seed + 7919u * slot);
+            for (int attempt = 0; attempt < attemptsPerCandidate && !found[slot]; ++attempt)
+            {
+                vector<pair<int, int>> candidate = edges;
+                DoubleEdgeSwapper swapper(candidate);
+                for (long long swaps = 0; swaps < swapBudget; ++swaps)
+                {
+                    if (swapper.randomize(1, gen) == 0)
+                        continue;
+                    if (!isIsomorphic(original, buildCsrGraph(numVertices, candidate), mapping))
+                    {
+                        candidates[slot] = std::move(candidate);
+                        found[slot] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+        };
+
+    vector<thread> workers;
+    for (int t = 1; t < numThreads; ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+
+    vector<vector<pair<int, int>>> distractors;
+    unordered_map<uint64_t, vector<vector<int>>> seen; // canonical hash -> certificates
+    for (int slot = 0; slot < numDistractors; ++slot)
+    {
+        if (!found[slot])
+            continue;
+        CanonicalForm form = canonicalForm(buildCsrGraph(numVertices, candidates[slot]));
+        auto& certificates = seen[form.hash];
+        if (find(certificates.begin(), certificates.end(), form.certificate) != certificates.end())
+            continue;
+        certificates.push_back(std::move(form.certificate));
+        distractors.push_back(std::move(candidates[slot]));
+    }
+    return distractors;
+}
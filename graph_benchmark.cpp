@@ -0,0 +1,614 @@
+// Benchmarks for the graph core: random generation, vertex shuffling, degree computation and
+// the isomorphism checker, on both graph representations (BitGraph and CsrGraph). No display
+// is needed. Every benchmark is set up untimed and then run for doubling iteration counts
+// until one batch takes at least --min-time seconds; the best of --repetitions batches is
+// reported as nanoseconds per operation.
+//
+// Sweeps cover vertex count, edge count and density. The isomorphism checker is also run on
+// adversarial families that color refinement cannot split: strongly regular graphs (Paley
+// graphs, rook's graphs and the Shrikhande graph, which has the parameters of the 4x4 rook's
+// graph) and Cai-Furer-Immerman pairs, where a twisted and an untwisted copy of the same
+// gadget graph differ only globally.
+//
+// --corpus adds benchmarks over a graph file in any format graph_io.h reads, such as a
+// graph6 collection: one full streaming pass over the file, and the isomorphism checker on
+// its first graphs against relabeled copies.
+//
+// usage:
+//   graph_benchmark [--filter text] [--min-time seconds] [--repetitions count] [--corpus file]
+//                   [--format console|json|csv] [--out file] [--baseline file] [--threshold percent] [--list]
+//
+// --format picks what goes to stdout; --out also writes JSON to a file, one benchmark per
+// line. --baseline reads such a file from an earlier build and adds the change per
+// benchmark; with --threshold the exit code is 1 when any benchmark got slower than that.
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "graph_io.h"
+
+using namespace std;
+
+// The timed part of a benchmark: one operation, returning something derived from its result
+// so the compiler cannot drop the work.
+typedef function<uint64_t()> Operation;
+
+struct Benchmark
+{
+    string name;
+    function<Operation()> prepare; // untimed setup; returns the operation to time
+};
+
+struct Result
+{
+    string name;
+    long long iterations = 0;
+    double nsPerOperation = 0;
+    double baseline = -1; // ns per operation in the baseline file, -1 if absent
+    string error;
+};
+
+volatile uint64_t sink;
+
+vector<Benchmark> benchmarks;
+
+void add(const string& name, function<Operation()> prepare)
+{
+    benchmarks.push_back(Benchmark{ name, std::move(prepare) });
+}
+
+string formatDensity(double density)
+{
+    char text[16];
+    snprintf(text, sizeof text, "%.2f", density);
+    return text;
+}
+
+long long edgesForDensity(int numVertices, double density)
+{
+    return (long long)(density * numVertices * (numVertices - 1) / 2);
+}
+
+// Paley graph on q vertices (q prime, q = 1 mod 4): i ~ j when i - j is a nonzero square.
+vector<pair<int, int>> paleyEdges(int q)
+{
+    vector<char> square(q, 0);
+    for (int x = 1; x < q; ++x)
+        square[(long long)x * x % q] = 1;
+    vector<pair<int, int>> edges;
+    for (int i = 0; i < q; ++i)
+        for (int j = i + 1; j < q; ++j)
+            if (square[j - i])
+                edges.emplace_back(i, j);
+    return edges;
+}
+
+// Rook's graph on an n x n board: cells sharing a row or a column are adjacent.
+vector<pair<int, int>> rookEdges(int n)
+{
+    vector<pair<int, int>> edges;
+    for (int a = 0; a < n * n; ++a)
+        for (int b = a + 1; b < n * n; ++b)
+            if (a / n == b / n || a % n == b % n)
+                edges.emplace_back(a, b);
+    return edges;
+}
+
+// Shrikhande graph: Z4 x Z4 with differences (+-1, 0), (0, +-1) and +-(1, 1). Strongly regular
+// with the parameters (16, 6, 2, 2) of the 4 x 4 rook's graph but not isomorphic to it.
+vector<pair<int, int>> shrikhandeEdges()
+{
+    vector<pair<int, int>> edges;
+    for (int a = 0; a < 16; ++a)
+    {
+        for (int b = a + 1; b < 16; ++b)
+        {
+            int dx = (b / 4 - a / 4 + 4) % 4, dy = (b % 4 - a % 4 + 4) % 4;
+            if ((dx == 0 && (dy == 1 || dy == 3)) || (dy == 0 && (dx == 1 || dx == 3)) || (dx == 1 && dy == 1) || (dx == 3 && dy == 3))
+                edges.emplace_back(a, b);
+        }
+    }
+    return edges;
+}
+
+// Prism over a k-cycle: two k-cycles joined by a perfect matching, 3-regular.
+vector<pair<int, int>> prismEdges(int k)
+{
+    vector<pair<int, int>> edges;
+    for (int i = 0; i < k; ++i)
+    {
+        edges.emplace_back(i, (i + 1) % k);
+        edges.emplace_back(k + i, k + (i + 1) % k);
+        edges.emplace_back(i, k + i);
+    }
+    return edges;
+}
+
+// Cai-Furer-Immerman graph over a connected base graph. Every base vertex v of degree d
+// becomes a gadget with two end vertices per incident edge and one middle vertex per
+// even-sized subset S of its incident edges, joined to end 1 of the edges in S and to end 0
+// of the others. A base edge joins the matching ends of its two gadgets, or the opposite
+// ends when twisted. Twisting one edge gives a graph that is not isomorphic to the untwisted
+// one although color refinement cannot tell them apart.
+void cfiGraph(int numBaseVertices, const vector<pair<int, int>>& baseEdges, bool twisted,
+    int& numVertices, vector<pair<int, int>>& edges)
+{
+    vector<vector<int>> incident(numBaseVertices);
+    for (int e = 0; e < (int)baseEdges.size(); ++e)
+    {
+        incident[baseEdges[e].first].push_back(e);
+        incident[baseEdges[e].second].push_back(e);
+    }
+    // endVertex[v][k] is end 0 of the k-th incident edge of v; end 1 follows it
+    vector<vector<int>> endVertex(numBaseVertices);
+    numVertices = 0;
+    edges.clear();
+    for (int v = 0; v < numBaseVertices; ++v)
+    {
+        int d = (int)incident[v].size();
+        for (int k = 0; k < d; ++k)
+        {
+            endVertex[v].push_back(numVertices);
+            numVertices += 2;
+        }
+        for (int subset = 0; subset < 1 << d; ++subset)
+        {
+            if (popcount64((uint64_t)subset) % 2 != 0)
+                continue;
+            int middle = numVertices++;
+            for (int k = 0; k < d; ++k)
+                edges.emplace_back(middle, endVertex[v][k] + (subset >> k & 1));
+        }
+    }
+    for (int e = 0; e < (int)baseEdges.size(); ++e)
+    {
+        int u = baseEdges[e].first, v = baseEdges[e].second;
+        int endU = endVertex[u][find(incident[u].begin(), incident[u].end(), e) - incident[u].begin()];
+        int endV = endVertex[v][find(incident[v].begin(), incident[v].end(), e) - incident[v].begin()];
+        int twist = twisted && e == 0 ? 1 : 0;
+        edges.emplace_back(endU, endV + twist);
+        edges.emplace_back(endU + 1, endV + 1 - twist);
+    }
+}
+
+void addGenerationBenchmarks()
+{
+    for (int numVertices : { 64, 256, 1024 })
+    {
+        for (double density : { 0.05, 0.25, 0.5, 0.9 })
+        {
+            long long numEdges = edgesForDensity(numVertices, density);
+            string suffix = "/V:" + to_string(numVertices) + "/density:" + formatDensity(density);
+            add("generateRandomGraph/bit" + suffix, [=]() -> Operation {
+                auto gen = make_shared<mt19937>(1);
+                return [=]() { return (uint64_t)generateRandomGraph(numVertices, (int)numEdges, *gen).bits[0]; };
+                });
+            add("generateRandomEdges/csr" + suffix, [=]() -> Operation {
+                auto gen = make_shared<mt19937>(1);
+                return [=]() { return (uint64_t)buildCsrGraph(numVertices, generateRandomEdges(numVertices, numEdges, *gen)).neighbors[0]; };
+                });
+        }
+    }
+    // Sparse graphs at a fixed edge count per vertex, where the CSR path is meant to be used
+    for (int numVertices : { 1024, 16384, 131072 })
+    {
+        for (int edgesPerVertex : { 2, 8 })
+        {
+            long long numEdges = (long long)edgesPerVertex * numVertices;
+            add("generateRandomEdges/csr/V:" + to_string(numVertices) + "/E:" + to_string(numEdges), [=]() -> Operation {
+                auto gen = make_shared<mt19937>(1);
+                return [=]() { return (uint64_t)buildCsrGraph(numVertices, generateRandomEdges(numVertices, numEdges, *gen)).neighbors[0]; };
+                });
+        }
+    }
+}
+
+void addShuffleAndDegreeBenchmarks()
+{
+    for (int numVertices : { 64, 256, 1024, 4096 })
+    {
+        for (double density : { 0.05, 0.5 })
+        {
+            long long numEdges = edgesForDensity(numVertices, density);
+            string suffix = "/V:" + to_string(numVertices) + "/density:" + formatDensity(density);
+            add("shuffleVerticesWithSameEdges/bit" + suffix, [=]() -> Operation {
+                auto gen = make_shared<mt19937>(2);
+                auto graph = make_shared<BitGraph>(generateRandomGraph(numVertices, (int)numEdges, *gen));
+                return [=]() {
+                    shuffleVerticesWithSameEdges(*graph, *gen);
+                    return (uint64_t)graph->bits[0];
+                    };
+                });
+            add("shuffleVerticesWithSameEdges/csr" + suffix, [=]() -> Operation {
+                auto gen = make_shared<mt19937>(2);
+                auto graph = make_shared<CsrGraph>(buildCsrGraph(numVertices, generateRandomEdges(numVertices, numEdges, *gen)));
+                return [=]() {
+                    shuffleVerticesWithSameEdges(*graph, *gen);
+                    return (uint64_t)graph->neighbors[0];
+                    };
+                });
+            add("calculateDegrees/bit" + suffix, [=]() -> Operation {
+                mt19937 gen(3);
+                auto graph = make_shared<BitGraph>(generateRandomGraph(numVertices, (int)numEdges, gen));
+                return [=]() { return (uint64_t)calculateDegrees(*graph)[0]; };
+                });
+            add("calculateDegrees/csr" + suffix, [=]() -> Operation {
+                mt19937 gen(3);
+                auto graph = make_shared<CsrGraph>(buildCsrGraph(numVertices, generateRandomEdges(numVertices, numEdges, gen)));
+                return [=]() { return (uint64_t)calculateDegrees(*graph)[0]; };
+                });
+        }
+    }
+}
+
+// Relabeled copies of graph 2 are made up front and taken in turn, so the timing covers the
+// check alone and does not depend on one lucky labeling.
+const int CopiesPerCheck = 8;
+
+void addIsomorphismBenchmark(const string& name, int numVertices, const vector<pair<int, int>>& edges1,
+    const vector<pair<int, int>>& edges2, bool expectIsomorphic)
+{
+    add("isIsomorphic/csr/" + name, [=]() -> Operation {
+        mt19937 gen(4);
+        auto graph1 = make_shared<CsrGraph>(buildCsrGraph(numVertices, edges1));
+        auto copies = make_shared<vector<CsrGraph>>();
+        for (int k = 0; k < CopiesPerCheck; ++k)
+        {
+            vector<int> permutation;
+            randomPermutation(permutation, numVertices, gen);
+            copies->push_back(relabelVertices(buildCsrGraph(numVertices, edges2), permutation));
+        }
+        auto next = make_shared<int>(0);
+        auto mapping = make_shared<vector<int>>();
+        return [=]() {
+            const CsrGraph& graph2 = (*copies)[(*next)++ % CopiesPerCheck];
+            if (isIsomorphic(*graph1, graph2, *mapping) != expectIsomorphic)
+                throw runtime_error("wrong answer");
+            return (uint64_t)mapping->size();
+            };
+        });
+    add("isIsomorphic/bit/" + name, [=]() -> Operation {
+        mt19937 gen(4);
+        auto graph1 = make_shared<BitGraph>(numVertices);
+        for (const auto& edge : edges1)
+            graph1->addEdge(edge.first, edge.second);
+        auto copies = make_shared<vector<BitGraph>>();
+        for (int k = 0; k < CopiesPerCheck; ++k)
+        {
+            vector<int> permutation;
+            randomPermutation(permutation, numVertices, gen);
+            BitGraph copy(numVertices);
+            for (const auto& edge : edges2)
+                copy.addEdge(permutation[edge.first], permutation[edge.second]);
+            copies->push_back(std::move(copy));
+        }
+        auto next = make_shared<int>(0);
+        auto mapping = make_shared<vector<int>>();
+        return [=]() {
+            const BitGraph& graph2 = (*copies)[(*next)++ % CopiesPerCheck];
+            if (isIsomorphic(toIsoGraph(*graph1), toIsoGraph(graph2), *mapping) != expectIsomorphic)
+                throw runtime_error("wrong answer");
+            return (uint64_t)mapping->size();
+            };
+        });
+}
+
+void addIsomorphismBenchmarks()
+{
+    // Random graphs: isomorphic copies, and same-degree-sequence distractors as the game uses
+    for (int numVertices : { 16, 48, 128, 512, 2048 })
+    {
+        for (double density : { 0.1, 0.5 })
+        {
+            mt19937 gen(5);
+            vector<pair<int, int>> edges = generateRandomEdges(numVertices, edgesForDensity(numVertices, density), gen);
+            string suffix = "V:" + to_string(numVertices) + "/density:" + formatDensity(density);
+            addIsomorphismBenchmark("random/" + suffix, numVertices, edges, edges, true);
+            if (numVertices <= 512)
+            {
+                vector<vector<pair<int, int>>> distractors = generateDistractors(numVertices, edges, 1, 5, 1);
+                if (!distractors.empty())
+                    addIsomorphismBenchmark("distractor/" + suffix, numVertices, edges, distractors[0], false);
+            }
+        }
+    }
+
+    // Strongly regular graphs: every vertex looks the same to color refinement
+    for (int q : { 13, 29, 61, 101, 197 })
+        addIsomorphismBenchmark("paley/V:" + to_string(q), q, paleyEdges(q), paleyEdges(q), true);
+    for (int n : { 4, 8, 16 })
+        addIsomorphismBenchmark("rook/V:" + to_string(n * n), n * n, rookEdges(n), rookEdges(n), true);
+    addIsomorphismBenchmark("rook-vs-shrikhande/V:16", 16, rookEdges(4), shrikhandeEdges(), false);
+
+    // CFI pairs over prisms: 20 vertices per base vertex pair
+    for (int k : { 3, 4, 6, 8 })
+    {
+        int numVertices;
+        vector<pair<int, int>> untwisted, twisted;
+        cfiGraph(2 * k, prismEdges(k), false, numVertices, untwisted);
+        cfiGraph(2 * k, prismEdges(k), true, numVertices, twisted);
+        string suffix = "/V:" + to_string(numVertices);
+        addIsomorphismBenchmark("cfi-same" + suffix, numVertices, untwisted, untwisted, true);
+        addIsomorphismBenchmark("cfi-twisted" + suffix, numVertices, untwisted, twisted, false);
+    }
+}
+
+// Graphs of the corpus checked against their relabeled copies; the rest is only read.
+const int CorpusSample = 1024;
+
+void addCorpusBenchmarks(const string& fileName)
+{
+    string name = "corpus:" + fileName.substr(fileName.find_last_of("/\\") + 1);
+    add("readGraphs/" + name, [=]() -> Operation {
+        auto mapped = make_shared<MappedFile>(fileName);
+        return [=]() {
+            FILE* file = nullptr;
+            if (!mapped->isOpen() && (file = fopen(fileName.c_str(), "rb")) == nullptr)
+                throw runtime_error("cannot open " + fileName);
+            GraphReader reader = file != nullptr ? GraphReader(file) : GraphReader(mapped->data(), mapped->size());
+            int numVertices;
+            vector<pair<int, int>> edges;
+            uint64_t count = 0;
+            while (reader.read(numVertices, edges))
+                count += edges.size() + 1;
+            if (file != nullptr)
+                fclose(file);
+            if (reader.failed())
+                throw runtime_error("malformed graph in " + fileName);
+            return count;
+            };
+        });
+    add("isIsomorphic/csr/" + name, [=]() -> Operation {
+        mt19937 gen(6);
+        auto pairs = make_shared<vector<pair<CsrGraph, CsrGraph>>>();
+        MappedFile mapped(fileName);
+        FILE* file = mapped.isOpen() ? nullptr : fopen(fileName.c_str(), "rb");
+        if (!mapped.isOpen() && file == nullptr)
+            throw runtime_error("cannot open " + fileName);
+        GraphReader reader = file != nullptr ? GraphReader(file) : GraphReader(mapped.data(), mapped.size());
+        int numVertices;
+        vector<pair<int, int>> edges;
+        while ((int)pairs->size() < CorpusSample && reader.read(numVertices, edges))
+        {
+            vector<int> permutation;
+            randomPermutation(permutation, numVertices, gen);
+            CsrGraph graph = buildCsrGraph(numVertices, edges);
+            CsrGraph copy = relabelVertices(graph, permutation);
+            pairs->emplace_back(std::move(graph), std::move(copy));
+        }
+        if (file != nullptr)
+            fclose(file);
+        if (reader.failed() || pairs->empty())
+            throw runtime_error("no graphs read from " + fileName);
+        auto next = make_shared<size_t>(0);
+        auto mapping = make_shared<vector<int>>();
+        return [=]() {
+            const auto& graphs = (*pairs)[(*next)++ % pairs->size()];
+            if (!isIsomorphic(graphs.first, graphs.second, *mapping))
+                throw runtime_error("wrong answer");
+            return (uint64_t)mapping->size();
+            };
+        });
+}
+
+Result run(const Benchmark& benchmark, double minTime, int repetitions)
+{
+    Result result;
+    result.name = benchmark.name;
+    try
+    {
+        Operation operation = benchmark.prepare();
+        sink = operation(); // warm-up, and the first answer check
+        for (int r = 0; r < repetitions; ++r)
+        {
+            for (long long iterations = 1;; iterations *= 2)
+            {
+                auto start = chrono::steady_clock::now();
+                uint64_t accumulated = 0;
+                for (long long i = 0; i < iterations; ++i)
+                    accumulated += operation();
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                sink = accumulated;
+                if (seconds >= minTime || iterations >= (1LL << 40))
+                {
+                    double ns = seconds * 1e9 / iterations;
+                    if (result.iterations == 0 || ns < result.nsPerOperation)
+                    {
+                        result.nsPerOperation = ns;
+                        result.iterations = iterations;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    catch (const exception& e)
+    {
+        result.error = e.what();
+    }
+    return result;
+}
+
+// Reads the "name" and "ns_per_op" fields of a JSON file written with --out.
+map<string, double> readBaseline(const string& fileName)
+{
+    map<string, double> baseline;
+    ifstream file(fileName);
+    string line;
+    while (getline(file, line))
+    {
+        size_t name = line.find("\"name\": \"");
+        size_t time = line.find("\"ns_per_op\": ");
+        if (name == string::npos || time == string::npos)
+            continue;
+        name += 9;
+        baseline[line.substr(name, line.find('"', name) - name)] = atof(line.c_str() + time + 13);
+    }
+    return baseline;
+}
+
+double changePercent(const Result& result)
+{
+    return (result.nsPerOperation / result.baseline - 1) * 100;
+}
+
+void writeJson(ostream& out, const vector<Result>& results, double minTime, int repetitions)
+{
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    out << "{\n";
+    out << "  \"context\": {\"date\": \"" << date << "\", \"num_cpus\": " << thread::hardware_concurrency()
+        << ", \"min_time\": " << minTime << ", \"repetitions\": " << repetitions
+#ifdef NDEBUG
+        << ", \"build_type\": \"release\"},\n";
+#else
+        << ", \"build_type\": \"debug\"},\n";
+#endif
+    out << "  \"benchmarks\": [\n" << fixed << setprecision(1);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        out << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.nsPerOperation;
+        if (result.baseline > 0)
+            out << ", \"baseline_ns_per_op\": " << result.baseline << ", \"change_percent\": " << changePercent(result);
+        if (!result.error.empty())
+            out << ", \"error\": \"" << result.error << "\"";
+        out << (i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    out << "  ]\n}\n";
+}
+
+void writeCsv(ostream& out, const vector<Result>& results)
+{
+    out << fixed << setprecision(1) << "name,iterations,ns_per_op,baseline_ns_per_op,change_percent,error\n";
+    for (const Result& result : results)
+    {
+        out << result.name << "," << result.iterations << "," << result.nsPerOperation << ",";
+        if (result.baseline > 0)
+            out << result.baseline << "," << changePercent(result);
+        else
+            out << ",";
+        out << "," << result.error << "\n";
+    }
+}
+
+void writeConsoleLine(const Result& result)
+{
+    if (!result.error.empty())
+    {
+        printf("%-64s ERROR: %s\n", result.name.c_str(), result.error.c_str());
+        return;
+    }
+    printf("%-64s %14.1f ns %12lld", result.name.c_str(), result.nsPerOperation, result.iterations);
+    if (result.baseline > 0)
+        printf(" %+8.1f%%", changePercent(result));
+    printf("\n");
+    fflush(stdout);
+}
+
+int usage()
+{
+    cerr << "usage: graph_benchmark [--filter text] [--min-time seconds] [--repetitions count] [--corpus file]" << endl;
+    cerr << "                       [--format console|json|csv] [--out file] [--baseline file] [--threshold percent] [--list]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    string filter, format = "console", outName, baselineName, corpusName;
+    double minTime = 0.2, threshold = -1;
+    int repetitions = 1;
+    bool listOnly = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--filter" && hasValue)
+            filter = argv[++i];
+        else if (argument == "--min-time" && hasValue)
+            minTime = atof(argv[++i]);
+        else if (argument == "--repetitions" && hasValue)
+            repetitions = max(1, atoi(argv[++i]));
+        else if (argument == "--format" && hasValue)
+            format = argv[++i];
+        else if (argument == "--out" && hasValue)
+            outName = argv[++i];
+        else if (argument == "--baseline" && hasValue)
+            baselineName = argv[++i];
+        else if (argument == "--corpus" && hasValue)
+            corpusName = argv[++i];
+        else if (argument == "--threshold" && hasValue)
+            threshold = atof(argv[++i]);
+        else if (argument == "--list")
+            listOnly = true;
+        else
+            return usage();
+    }
+    if (format != "console" && format != "json" && format != "csv")
+        return usage();
+
+    addGenerationBenchmarks();
+    addShuffleAndDegreeBenchmarks();
+    addIsomorphismBenchmarks();
+    if (!corpusName.empty())
+        addCorpusBenchmarks(corpusName);
+
+    map<string, double> baseline;
+    if (!baselineName.empty())
+        baseline = readBaseline(baselineName);
+
+    if (format == "console" && !listOnly)
+        printf("%-64s %17s %12s%s\n", "benchmark", "time/op", "iterations", baseline.empty() ? "" : "    change");
+    vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (benchmark.name.find(filter) == string::npos)
+            continue;
+        if (listOnly)
+        {
+            cout << benchmark.name << "\n";
+            continue;
+        }
+        Result result = run(benchmark, minTime, repetitions);
+        auto it = baseline.find(result.name);
+        if (it != baseline.end())
+            result.baseline = it->second;
+        if (format == "console")
+            writeConsoleLine(result);
+        results.push_back(result);
+    }
+    if (listOnly)
+        return 0;
+
+    if (format == "json")
+        writeJson(cout, results, minTime, repetitions);
+    else if (format == "csv")
+        writeCsv(cout, results);
+    if (!outName.empty())
+    {
+        ofstream out(outName);
+        writeJson(out, results, minTime, repetitions);
+    }
+
+    int exitCode = 0;
+    for (const Result& result : results)
+    {
+        if (!result.error.empty())
+            exitCode = 1;
+        else if (threshold >= 0 && result.baseline > 0 && changePercent(result) > threshold)
+        {
+            cerr << result.name << " is " << changePercent(result) << "% slower than the baseline" << endl;
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+// Precomputed catalog of every simple graph in the game's range (up to 10 vertices), one
+// fixed-size record per isomorphism class. catalog_builder writes the file; the game maps
+// it read-only at startup and answers queries by binary search, with nothing to parse.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "graph.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const int CatalogMaxVertices = 10;
+const char CatalogMagic[8] = { 'I', 'S', 'O', 'C', 'A', 'T', '0', '1' };
+
+// Records are sorted by (numVertices, numEdges, degrees, adjacency), so every
+// (V, E, degree sequence) group is a contiguous range.
+struct CatalogRecord
+{
+    uint8_t numVertices;
+    uint8_t numEdges;
+    uint8_t degrees[CatalogMaxVertices]; // sorted descending, zero padded
+    uint32_t automorphismCount;
+    uint64_t adjacency; // bit k set if pair k (pairFromIndex order) is an edge, canonical labeling
+};
+
+struct CatalogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+};
+
+inline bool operator<(const CatalogRecord& a, const CatalogRecord& b)
+{
+    if (a.numVertices != b.numVertices)
+        return a.numVertices < b.numVertices;
+    if (a.numEdges != b.numEdges)
+        return a.numEdges < b.numEdges;
+    int order = memcmp(a.degrees, b.degrees, CatalogMaxVertices);
+    if (order != 0)
+        return order < 0;
+    return a.adjacency < b.adjacency;
+}
+
+// Orders records by (V, E, degree sequence) only, for group lookups.
+inline bool lessByDegrees(const CatalogRecord& a, const CatalogRecord& b)
+{
+    if (a.numVertices != b.numVertices)
+        return a.numVertices < b.numVertices;
+    if (a.numEdges != b.numEdges)
+        return a.numEdges < b.numEdges;
+    return memcmp(a.degrees, b.degrees, CatalogMaxVertices) < 0;
+}
+
+// Builds the catalog key of a graph: canonical labeling, then the adjacency bits under it.
+// Returns false for graphs the catalog cannot hold (multigraphs, loops, too many vertices).
+inline bool makeCatalogRecord(const CsrGraph& graph, CatalogRecord& record)
+{
+    int n = graph.numVertices;
+    if (n > CatalogMaxVertices || hasParallelEdges(graph))
+        return false;
+    for (int v = 0; v < n; ++v)
+    {
+        if (binary_search(graph.begin(v), graph.end(v), v))
+            return false;
+    }
+
+    CanonicalForm form = canonicalForm(graph);
+    memset(&record, 0, sizeof(record));
+    record.numVertices = n;
+    record.numEdges = graph.neighbors.size() / 2;
+    record.automorphismCount = (uint32_t)form.automorphismCount;
+    vector<int> degrees = calculateDegrees(graph);
+    sort(degrees.rbegin(), degrees.rend());
+    for (int v = 0; v < n; ++v)
+        record.degrees[v] = degrees[v];
+    forEachEdge(graph, [&](int i, int j) {
+        int a = min(form.labeling[i], form.labeling[j]);
+        int b = max(form.labeling[i], form.labeling[j]);
+        record.adjacency |= uint64_t(1) << (pairRowStart(n, a) + b - a - 1);
+        });
+    return true;
+}
+
+inline vector<pair<int, int>> catalogRecordEdges(const CatalogRecord& record)
+{
+    vector<pair<int, int>> edges;
+    for (uint64_t bits = record.adjacency; bits != 0; bits &= bits - 1)
+        edges.push_back(pairFromIndex(record.numVertices, countTrailingZeros64(bits)));
+    return edges;
+}
+
+// Read-only memory mapping of a catalog file.
+class GraphCatalog
+{
+public:
+    GraphCatalog() = default;
+    GraphCatalog(const GraphCatalog&) = delete;
+    GraphCatalog& operator=(const GraphCatalog&) = delete;
+    ~GraphCatalog() { close(); }
+
+    bool open(const string& path)
+    {
+        close();
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        mappedSize = (size_t)fileSize.QuadPart;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat info;
+        fstat(descriptor, &info);
+        mappedSize = info.st_size;
+        data = mappedSize > 0 ? mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+        if (data == MAP_FAILED)
+            data = nullptr;
+#endif
+        if (data == nullptr || mappedSize < sizeof(CatalogHeader))
+        {
+            close();
+            return false;
+        }
+        const CatalogHeader* header = static_cast<const CatalogHeader*>(data);
+        if (memcmp(header->magic, CatalogMagic, sizeof(CatalogMagic)) != 0 || header->recordSize != sizeof(CatalogRecord)
+            || sizeof(CatalogHeader) + header->recordCount * sizeof(CatalogRecord) > mappedSize)
+        {
+            close();
+            return false;
+        }
+        records = reinterpret_cast<const CatalogRecord*>(static_cast<const char*>(data) + sizeof(CatalogHeader));
+        count = header->recordCount;
+        return true;
+    }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data)
+            munmap(data, mappedSize);
+        if (descriptor >= 0)
+            ::close(descriptor);
+        descriptor = -1;
+#endif
+        data = nullptr;
+        records = nullptr;
+        count = 0;
+        mappedSize = 0;
+    }
+
+    bool isOpen() const { return records != nullptr; }
+    size_t size() const { return count; }
+    const CatalogRecord* begin() const { return records; }
+    const CatalogRecord* end() const { return records + count; }
+
+    // All classes with the same vertex count, edge count and degree sequence as `key`.
+    pair<const CatalogRecord*, const CatalogRecord*> sameDegreeSequence(const CatalogRecord& key) const
+    {
+        return equal_range(begin(), end(), key, lessByDegrees);
+    }
+
+    // All classes with V vertices and E edges.
+    pair<const CatalogRecord*, const CatalogRecord*> withSize(int numVertices, int numEdges) const
+    {
+        auto first = lower_bound(begin(), end(), make_pair(numVertices, numEdges), [](const CatalogRecord& r, const pair<int, int>& key) {
+            return make_pair((int)r.numVertices, (int)r.numEdges) < key;
+            });
+        auto last = upper_bound(first, end(), make_pair(numVertices, numEdges), [](const pair<int, int>& key, const CatalogRecord& r) {
+            return key < make_pair((int)r.numVertices, (int)r.numEdges);
+            });
+        return { first, last };
+    }
+
+    const CatalogRecord* find(const CatalogRecord& key) const
+    {
+        const CatalogRecord* it = lower_bound(begin(), end(), key);
+        return it != end() && !(key < *it) ? it : nullptr;
+    }
+
+private:
+    void* data = nullptr;
+    size_t mappedSize = 0;
+    const CatalogRecord* records = nullptr;
+    size_t count = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
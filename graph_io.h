@@ -0,0 +1,724 @@
+#pragma once
+
+// Graph exchange for the command-line tools and for saving graphs to disk, in four formats:
+//
+// Text: a graph is its vertex and edge counts followed by one "u v" pair per edge, vertices
+// numbered from 1 as on the board:
+//
+//     4 3
+//     1 2
+//     2 3
+//     3 4
+//
+// Whitespace layout is free, so many graphs can simply follow each other in one stream.
+//
+// graph6 and sparse6: the standard compact ASCII formats of nauty and the public graph
+// collections, one graph per line. graph6 stores the upper triangle of the adjacency matrix
+// six bits per character and holds simple graphs only; sparse6 lines start with ':' and
+// store an edge list, loops and parallel edges included. The two may be mixed in one file,
+// and an optional ">>graph6<<" or ">>sparse6<<" header is skipped.
+//
+// Binary: BinaryGraphMagic once at the start of the stream, then per graph the byte length
+// of the rest of the record followed by the vertex count, the edge count and the endpoints
+// of every edge (from 0), all as LEB128 varints. The length lets a reader skip a record
+// without decoding it.
+//
+// GraphReader streams any of them from a FILE* through a fixed buffer, or from memory such
+// as a MappedFile, so corpora larger than memory are read at I/O speed.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <cctype>
+#include <charconv>
+#include "graph.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum class GraphFormat
+{
+    Auto, // reading only: decided by the first byte of the stream
+    Text,
+    Graph6, // reading either Graph6 or Sparse6 accepts both
+    Sparse6,
+    Binary,
+};
+
+const char BinaryGraphMagic[4] = { '\x89', 'G', 'R', 'F' }; // high bit set, so text never starts with it
+
+// "text", "graph6", "sparse6" or "binary"; false for anything else.
+inline bool parseGraphFormat(const string& name, GraphFormat& format)
+{
+    if (name == "text")
+        format = GraphFormat::Text;
+    else if (name == "graph6")
+        format = GraphFormat::Graph6;
+    else if (name == "sparse6")
+        format = GraphFormat::Sparse6;
+    else if (name == "binary")
+        format = GraphFormat::Binary;
+    else
+        return false;
+    return true;
+}
+
+// Number of bits needed to write n - 1, as sparse6 uses for every vertex number.
+inline int sparse6Width(long long n)
+{
+    int k = 0;
+    for (long long i = n - 1; i > 0; i >>= 1)
+        ++k;
+    return k;
+}
+
+// Edges reserved up front at most; the counts come from the input, so a larger graph has to
+// prove itself edge by edge while the vector grows.
+const long long MaxEdgeReserve = 1 << 16;
+
+// Buffered reader over a FILE*, or a reader over bytes already in memory. Parses straight
+// out of the buffer instead of going through iostreams, which matters when a run reads
+// millions of graphs.
+class GraphReader
+{
+public:
+    explicit GraphReader(FILE* file, GraphFormat format = GraphFormat::Auto)
+        : file(file), format(format), storage(1 << 16), buffer(storage.data()) {}
+
+    // The bytes must outlive the reader.
+    GraphReader(const char* data, size_t size, GraphFormat format = GraphFormat::Auto)
+        : file(nullptr), format(format), buffer(data), length(size) {}
+
+    // buffer may point into storage
+    GraphReader(const GraphReader&) = delete;
+    GraphReader& operator=(const GraphReader&) = delete;
+
+    // Reads the next graph. Returns false at end of input or on malformed input; failed()
+    // tells the two apart.
+    bool read(int& numVertices, vector<pair<int, int>>& edges)
+    {
+        edges.clear();
+        if (format == GraphFormat::Auto && !detectFormat())
+            return false;
+        switch (format)
+        {
+        case GraphFormat::Text:
+            return readText(numVertices, edges);
+        case GraphFormat::Binary:
+            return readBinary(numVertices, edges);
+        default:
+            return readLine6(numVertices, edges);
+        }
+    }
+
+    bool failed() const { return error; }
+
+    // Makes a graph with more vertices or edges fail, as soon as its header or its edges
+    // show it, before it takes the memory. For readers of untrusted input.
+    void setLimits(long long maxVertices, long long maxEdges)
+    {
+        vertexLimit = maxVertices;
+        edgeLimit = maxEdges;
+    }
+
+    // Whether the failure was a graph over the limits.
+    bool exceededLimits() const { return overLimits; }
+
+private:
+    bool fail()
+    {
+        error = true;
+        return false;
+    }
+
+    bool failOverLimits()
+    {
+        overLimits = true;
+        return fail();
+    }
+
+    // Refills the buffer once it is drained; returns false at end of input.
+    bool fill()
+    {
+        if (position < length)
+            return true;
+        if (file == nullptr)
+            return false;
+        bufferStart += length;
+        length = fread(storage.data(), 1, storage.size(), file);
+        position = 0;
+        return length > 0;
+    }
+
+    // The next byte, or -1 at end of input.
+    int peekByte() { return fill() ? (unsigned char)buffer[position] : -1; }
+    int nextByte() { return fill() ? (unsigned char)buffer[position++] : -1; }
+
+    bool detectFormat()
+    {
+        int c = peekByte();
+        if (c < 0)
+            return false;
+        if (c == (unsigned char)BinaryGraphMagic[0])
+            format = GraphFormat::Binary;
+        else if (c == ':' || c == '>' || (c >= 63 && c <= 126))
+            format = GraphFormat::Graph6;
+        else
+            format = GraphFormat::Text;
+        return true;
+    }
+
+    bool readText(int& numVertices, vector<pair<int, int>>& edges)
+    {
+        long long n, m;
+        if (!readInteger(n))
+            return false;
+        if (!readInteger(m) || n < 0 || m < 0 || n > INT32_MAX)
+            return fail();
+        if (n > vertexLimit || m > edgeLimit)
+            return failOverLimits();
+        numVertices = (int)n;
+        edges.reserve((size_t)min(m, MaxEdgeReserve));
+        for (long long e = 0; e < m; ++e)
+        {
+            long long u, v;
+            if (!readInteger(u) || !readInteger(v) || u < 1 || v < 1 || u > n || v > n)
+                return fail();
+            edges.emplace_back((int)u - 1, (int)v - 1);
+        }
+        return true;
+    }
+
+    bool readInteger(long long& value)
+    {
+        while (fill() && isspace((unsigned char)buffer[position]))
+            ++position;
+        if (!fill())
+            return false;
+        bool negative = buffer[position] == '-';
+        if (negative)
+            ++position;
+        if (!fill() || !isdigit((unsigned char)buffer[position]))
+            return fail();
+        value = 0;
+        while (fill() && isdigit((unsigned char)buffer[position]))
+        {
+            if (value > (INT64_MAX - 9) / 10)
+                return fail();
+            value = value * 10 + (buffer[position++] - '0');
+        }
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = nextByte();
+            if (byte < 0)
+                return false;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return true;
+        }
+        return false;
+    }
+
+    bool readBinary(int& numVertices, vector<pair<int, int>>& edges)
+    {
+        if (!binaryHeaderRead)
+        {
+            for (char expected : BinaryGraphMagic)
+            {
+                if (nextByte() != (unsigned char)expected)
+                    return fail();
+            }
+            binaryHeaderRead = true;
+        }
+        if (peekByte() < 0)
+            return false;
+        uint64_t recordLength, n, m;
+        if (!readVarint(recordLength))
+            return fail();
+        uint64_t start = bytesConsumed();
+        if (!readVarint(n) || !readVarint(m) || n > INT32_MAX || m > recordLength)
+            return fail();
+        if ((long long)n > vertexLimit || (long long)m > edgeLimit)
+            return failOverLimits();
+        numVertices = (int)n;
+        edges.reserve((size_t)min<uint64_t>(m, MaxEdgeReserve));
+        for (uint64_t e = 0; e < m; ++e)
+        {
+            uint64_t u, v;
+            if (!readVarint(u) || !readVarint(v) || u >= n || v >= n)
+                return fail();
+            edges.emplace_back((int)u, (int)v);
+        }
+        if (bytesConsumed() - start != recordLength)
+            return fail();
+        return true;
+    }
+
+    uint64_t bytesConsumed() const { return bufferStart + position; }
+
+    // One graph6 or sparse6 line.
+    bool readLine6(int& numVertices, vector<pair<int, int>>& edges)
+    {
+        int c = peekByte();
+        while (c == '\n' || c == '\r')
+        {
+            ++position;
+            c = peekByte();
+        }
+        if (c < 0)
+            return false;
+        if (c == '>' && !skipHeader())
+            return fail();
+        bool sparse = peekByte() == ':';
+        if (sparse)
+            ++position;
+        long long n;
+        if (!readSize6(n))
+            return fail();
+        if (n > vertexLimit)
+            return failOverLimits();
+        numVertices = (int)n;
+        if (!(sparse ? readSparse6Body(n, edges) : readGraph6Body(n, edges)))
+            return fail();
+        c = peekByte();
+        if (c == '\r')
+        {
+            ++position;
+            c = peekByte();
+        }
+        if (c == '\n')
+            ++position;
+        else if (c >= 0)
+            return fail();
+        return true;
+    }
+
+    bool skipHeader()
+    {
+        string header;
+        while (header.size() < 11 && (header.size() < 2 || header.back() != '<' || header[header.size() - 2] != '<'))
+        {
+            int c = nextByte();
+            if (c < 0)
+                return false;
+            header += (char)c;
+        }
+        return header == ">>graph6<<" || header == ">>sparse6<<";
+    }
+
+    // Six-bit digit of a graph6/sparse6 character, or -1 if it is not one.
+    int nextDigit6()
+    {
+        int c = peekByte();
+        if (c < 63 || c > 126)
+            return -1;
+        ++position;
+        return c - 63;
+    }
+
+    bool readSize6(long long& n)
+    {
+        int digit = nextDigit6();
+        if (digit < 0)
+            return false;
+        if (digit < 63)
+        {
+            n = digit;
+            return true;
+        }
+        int digits = 3;
+        if (peekByte() == 126)
+        {
+            ++position;
+            digits = 6;
+        }
+        n = 0;
+        for (int i = 0; i < digits; ++i)
+        {
+            if ((digit = nextDigit6()) < 0)
+                return false;
+            n = n << 6 | digit;
+        }
+        return n <= INT32_MAX;
+    }
+
+    bool readGraph6Body(long long n, vector<pair<int, int>>& edges)
+    {
+        // Bits run down the columns of the upper triangle: (0,1), (0,2), (1,2), (0,3), ...
+        long long i = 0, j = 1;
+        long long numBits = n * (n - 1) / 2;
+        for (long long bit = 0; bit < numBits; bit += 6)
+        {
+            int digit = nextDigit6();
+            if (digit < 0)
+                return false;
+            for (int b = 5; b >= 0 && j < n; --b)
+            {
+                if (digit >> b & 1)
+                {
+                    if ((long long)edges.size() >= edgeLimit)
+                        return failOverLimits();
+                    edges.emplace_back((int)i, (int)j);
+                }
+                if (++i == j)
+                {
+                    i = 0;
+                    ++j;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Every edge is a bit b and a vertex number x of k bits: b = 1 moves on to the next
+    // vertex v, then x > v jumps to x and x <= v is the edge {x, v}. Padding to a whole
+    // character never decodes to an edge.
+    bool readSparse6Body(long long n, vector<pair<int, int>>& edges)
+    {
+        int k = sparse6Width(n);
+        long long v = 0;
+        int digit = 0, bitsLeft = 0;
+        auto nextBit = [&](int& bit) {
+            if (bitsLeft == 0)
+            {
+                if ((digit = nextDigit6()) < 0)
+                    return false;
+                bitsLeft = 6;
+            }
+            bit = digit >> --bitsLeft & 1;
+            return true;
+        };
+        for (;;)
+        {
+            int b, bit;
+            if (!nextBit(b))
+                break;
+            long long x = 0;
+            bool complete = true;
+            for (int i = 0; i < k && complete; ++i)
+            {
+                complete = nextBit(bit);
+                x = x << 1 | bit;
+            }
+            if (!complete)
+                break;
+            if (b)
+                ++v;
+            if (v >= n)
+                break;
+            if (x > v)
+                v = x;
+            else if ((long long)edges.size() >= edgeLimit)
+                return failOverLimits();
+            else
+                edges.emplace_back((int)x, (int)v);
+        }
+        // Whatever stopped the loop, the line must end at a non-digit
+        return nextDigit6() < 0;
+    }
+
+    FILE* file;
+    GraphFormat format;
+    vector<char> storage; // the buffer when reading from a file
+    const char* buffer;
+    size_t position = 0;
+    size_t length = 0;
+    uint64_t bufferStart = 0;
+    bool binaryHeaderRead = false;
+    long long vertexLimit = INT32_MAX;
+    long long edgeLimit = INT64_MAX;
+    bool error = false;
+    bool overLimits = false;
+};
+
+// A whole file mapped read-only into memory, for GraphReader's in-memory constructor. The
+// system pages it in as it is read, so files larger than memory work too. isOpen() is false
+// when the file could not be opened or mapped (a pipe, for one); read it through a FILE* then.
+class MappedFile
+{
+public:
+    explicit MappedFile(const string& fileName)
+    {
+#if defined(_WIN32)
+        HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(handle, &fileSize) && (unsigned long long)fileSize.QuadPart <= SIZE_MAX)
+        {
+            mappedSize = (size_t)fileSize.QuadPart;
+            opened = mappedSize == 0;
+            HANDLE mapping = mappedSize > 0 ? CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+            if (mapping != nullptr)
+            {
+                mappedData = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                opened = mappedData != nullptr;
+                CloseHandle(mapping); // the view keeps the mapping alive
+            }
+        }
+        CloseHandle(handle);
+#else
+        int descriptor = open(fileName.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && (unsigned long long)status.st_size <= SIZE_MAX)
+        {
+            mappedSize = (size_t)status.st_size;
+            opened = mappedSize == 0;
+            void* address = mappedSize > 0 ? mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, descriptor, 0) : MAP_FAILED;
+            if (address != MAP_FAILED)
+            {
+                madvise(address, mappedSize, MADV_SEQUENTIAL);
+                mappedData = (const char*)address;
+                opened = true;
+            }
+        }
+        close(descriptor); // the mapping stays valid
+#endif
+        if (!opened)
+            mappedSize = 0;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (mappedData == nullptr)
+            return;
+#if defined(_WIN32)
+        UnmapViewOfFile(mappedData);
+#else
+        munmap((void*)mappedData, mappedSize);
+#endif
+    }
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+
+private:
+    const char* mappedData = nullptr;
+    size_t mappedSize = 0;
+    bool opened = false;
+};
+
+inline void appendInteger(string& out, long long value)
+{
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end);
+}
+
+// Appends a graph in the text format above.
+inline void appendGraph(string& out, int numVertices, const vector<pair<int, int>>& edges)
+{
+    appendInteger(out, numVertices);
+    out += ' ';
+    appendInteger(out, (long long)edges.size());
+    out += '\n';
+    for (const auto& edge : edges)
+    {
+        appendInteger(out, edge.first + 1);
+        out += ' ';
+        appendInteger(out, edge.second + 1);
+        out += '\n';
+    }
+}
+
+inline void appendSize6(string& out, long long n)
+{
+    if (n < 63)
+    {
+        out += (char)(63 + n);
+        return;
+    }
+    int digits = n < 258048 ? 3 : 6;
+    out += (char)126;
+    if (digits == 6)
+        out += (char)126;
+    for (int i = digits - 1; i >= 0; --i)
+        out += (char)(63 + (n >> (6 * i) & 63));
+}
+
+// Appends a graph6 line. Returns false (and appends nothing) if the graph has loops or
+// parallel edges, which graph6 cannot hold.
+inline bool appendGraph6(string& out, int numVertices, const vector<pair<int, int>>& edges)
+{
+    long long n = numVertices;
+    vector<uint8_t> bits((size_t)(n * (n - 1) / 2), 0);
+    for (const auto& edge : edges)
+    {
+        long long i = min(edge.first, edge.second), j = max(edge.first, edge.second);
+        if (i == j)
+            return false;
+        uint8_t& bit = bits[(size_t)(j * (j - 1) / 2 + i)];
+        if (bit)
+            return false;
+        bit = 1;
+    }
+    appendSize6(out, n);
+    for (size_t start = 0; start < bits.size(); start += 6)
+    {
+        int digit = 0;
+        for (size_t b = start; b < start + 6; ++b)
+            digit = digit << 1 | (b < bits.size() ? bits[b] : 0);
+        out += (char)(63 + digit);
+    }
+    out += '\n';
+    return true;
+}
+
+// Appends a sparse6 line; any graph can be written.
+inline void appendSparse6(string& out, int numVertices, const vector<pair<int, int>>& edges)
+{
+    long long n = numVertices;
+    int k = sparse6Width(n);
+    out += ':';
+    appendSize6(out, n);
+
+    // Edges as (larger, smaller), in order of the larger endpoint
+    vector<pair<int, int>> sorted;
+    sorted.reserve(edges.size());
+    for (const auto& edge : edges)
+        sorted.emplace_back(max(edge.first, edge.second), min(edge.first, edge.second));
+    sort(sorted.begin(), sorted.end());
+
+    int digit = 0, bitCount = 0;
+    auto put = [&](int bit) {
+        digit = digit << 1 | bit;
+        if (++bitCount == 6)
+        {
+            out += (char)(63 + digit);
+            digit = 0;
+            bitCount = 0;
+        }
+    };
+    auto putVertex = [&](long long x) {
+        for (int i = k - 1; i >= 0; --i)
+            put(x >> i & 1);
+    };
+    long long v = 0;
+    for (const auto& edge : sorted)
+    {
+        long long w = edge.first, u = edge.second;
+        if (w == v)
+        {
+            put(0);
+            putVertex(u);
+        }
+        else if (w == v + 1)
+        {
+            put(1);
+            putVertex(u);
+        }
+        else
+        {
+            put(1);
+            putVertex(w);
+            put(0);
+            putVertex(u);
+        }
+        v = w;
+    }
+    if (bitCount > 0)
+    {
+        // Padding with 1-bits would read as the edge {n-1, n-1} right after vertex n-2 when n
+        // is a power of two; a leading 0-bit keeps it harmless
+        int padding = 6 - bitCount;
+        if (k < 6 && n == (1LL << k) && v == n - 2 && padding > k)
+        {
+            put(0);
+            --padding;
+        }
+        while (padding-- > 0)
+            put(1);
+    }
+    out += '\n';
+}
+
+inline void appendVarint(string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += (char)(value | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+// Appends one binary record; the stream must start with BinaryGraphMagic (see
+// appendGraphStreamHeader).
+inline void appendBinaryGraph(string& out, int numVertices, const vector<pair<int, int>>& edges)
+{
+    string record;
+    appendVarint(record, numVertices);
+    appendVarint(record, edges.size());
+    for (const auto& edge : edges)
+    {
+        appendVarint(record, edge.first);
+        appendVarint(record, edge.second);
+    }
+    appendVarint(out, record.size());
+    out += record;
+}
+
+// What a stream in `format` starts with: the magic for binary, nothing otherwise.
+inline void appendGraphStreamHeader(string& out, GraphFormat format)
+{
+    if (format == GraphFormat::Binary)
+        out.append(BinaryGraphMagic, sizeof BinaryGraphMagic);
+}
+
+// Appends a graph in any format. Only graph6 can fail, on loops and parallel edges.
+inline bool appendGraph(string& out, GraphFormat format, int numVertices, const vector<pair<int, int>>& edges)
+{
+    switch (format)
+    {
+    case GraphFormat::Graph6:
+        return appendGraph6(out, numVertices, edges);
+    case GraphFormat::Sparse6:
+        appendSparse6(out, numVertices, edges);
+        return true;
+    case GraphFormat::Binary:
+        appendBinaryGraph(out, numVertices, edges);
+        return true;
+    default:
+        appendGraph(out, numVertices, edges);
+        return true;
+    }
+}
+
+// Appends one graph to a file, creating it (with its stream header) if it does not exist.
+inline bool saveGraph(const string& fileName, GraphFormat format, int numVertices, const vector<pair<int, int>>& edges)
+{
+    string out;
+    FILE* file = fopen(fileName.c_str(), "ab");
+    if (file == nullptr)
+        return false;
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0)
+        appendGraphStreamHeader(out, format);
+    bool written = appendGraph(out, format, numVertices, edges) && fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && written;
+}
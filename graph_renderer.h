@@ -0,0 +1,674 @@
+#pragma once
+
+// Batched graph drawing. Every vertex shape, edge, loop and label of a graph lives in a few
+// persistent vertex buffers (one for lines, one for shapes, one per label size), so a frame
+// is a handful of draw calls however large the graph is. Each element owns a fixed slot in
+// its buffer; moving a vertex rewrites only its own slot and the slots of its incident
+// edges, and only that dirty range is uploaded on the next draw.
+//
+// Only what the target's view shows is submitted: when part of the graph is off screen or
+// the view is zoomed far out, the visible slots are gathered through a tile grid into
+// separate buffers, rebuilt only when the graph or the view changes. Level of detail
+// follows the on-screen size: labels disappear when they would be unreadable, vertices
+// become single points, and at the farthest zoom edges between the same two screen cells
+// are merged into one line.
+//
+// Works with any sf::RenderTarget, including an offscreen sf::RenderTexture. When the GL
+// implementation has no vertex buffer support (some software renderers), the same vertex
+// arrays are drawn straight from memory instead.
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "spatial_index.h"
+
+using namespace std;
+
+struct VertexStyle
+{
+    float radius = 10.0f; // center to corner
+    int sides = 16; // 4 with rotation 45 draws a square
+    float rotation = 0.0f; // degrees
+    sf::Color fill = sf::Color::Red;
+    sf::Color outline = sf::Color::White;
+    float outlineThickness = 1.0f;
+    unsigned labelSize = 14;
+    sf::Color labelColor = sf::Color::Black;
+    sf::Vector2f labelOffset = sf::Vector2f(-6, -10); // label top left, relative to the center
+};
+
+// Vertices of one primitive type, mirrored in a vertex buffer that is grown and patched
+// lazily at draw time.
+class RenderLayer
+{
+public:
+    explicit RenderLayer(sf::PrimitiveType type = sf::Triangles) : type(type), buffer(type, sf::VertexBuffer::Dynamic) {}
+
+    size_t allocate(size_t count)
+    {
+        size_t first = vertices.size();
+        vertices.resize(first + count);
+        markDirty(first, count);
+        return first;
+    }
+
+    sf::Vertex* at(size_t index) { return vertices.data() + index; }
+    const sf::Vertex* at(size_t index) const { return vertices.data() + index; }
+
+    void append(const sf::Vertex* source, size_t count)
+    {
+        size_t first = allocate(count);
+        copy(source, source + count, vertices.begin() + first);
+    }
+    size_t size() const { return vertices.size(); }
+
+    void markDirty(size_t first, size_t count)
+    {
+        dirtyFirst = min(dirtyFirst, first);
+        dirtyLast = max(dirtyLast, first + count);
+    }
+
+    void clear()
+    {
+        vertices.clear();
+        dirtyFirst = SIZE_MAX;
+        dirtyLast = 0;
+    }
+
+    void draw(sf::RenderTarget& target, const sf::RenderStates& states) const
+    {
+        if (vertices.empty())
+            return;
+        if (!sf::VertexBuffer::isAvailable())
+        {
+            target.draw(vertices.data(), vertices.size(), type, states);
+            return;
+        }
+        if (buffer.getVertexCount() < vertices.size())
+        {
+            // Doubling keeps reallocations logarithmic while the user keeps adding edges
+            buffer.create(max(vertices.size(), 2 * buffer.getVertexCount()));
+            dirtyFirst = 0;
+            dirtyLast = vertices.size();
+        }
+        if (dirtyFirst < dirtyLast)
+        {
+            dirtyLast = min(dirtyLast, vertices.size());
+            buffer.update(vertices.data() + dirtyFirst, dirtyLast - dirtyFirst, (unsigned)dirtyFirst);
+            dirtyFirst = SIZE_MAX;
+            dirtyLast = 0;
+        }
+        target.draw(buffer, 0, vertices.size(), states);
+    }
+
+private:
+    sf::PrimitiveType type;
+    vector<sf::Vertex> vertices;
+    mutable sf::VertexBuffer buffer;
+    mutable size_t dirtyFirst = SIZE_MAX;
+    mutable size_t dirtyLast = 0;
+};
+
+const int EdgeCurveSegments = 12;
+
+// Points of the edge from p1 to p2: straight for the first edge between two vertices,
+// a quadratic bezier bowed to alternating sides for each parallel one, and a circle above
+// the vertex for a loop, nested loops growing outward. `radius` is the vertex radius.
+inline void edgeCurve(sf::Vector2f p1, sf::Vector2f p2, bool loop, int parallelIndex, float radius, vector<sf::Vector2f>& points)
+{
+    if (!loop && parallelIndex == 0)
+    {
+        points.assign({ p1, p2 });
+        return;
+    }
+    points.resize(EdgeCurveSegments + 1);
+    if (loop)
+    {
+        const float pi = 3.14159265f;
+        float r = radius * (0.8f + 0.4f * parallelIndex);
+        sf::Vector2f c = p1 - sf::Vector2f(0, r + radius * 0.5f);
+        for (int i = 0; i <= EdgeCurveSegments; ++i)
+        {
+            float a = pi / 2 + 2 * pi * i / EdgeCurveSegments;
+            points[i] = c + sf::Vector2f(cos(a), sin(a)) * r;
+        }
+        return;
+    }
+    sf::Vector2f d = p2 - p1;
+    float length = max(1.0f, sqrt(d.x * d.x + d.y * d.y));
+    sf::Vector2f normal(-d.y / length, d.x / length);
+    float side = parallelIndex % 2 == 1 ? 1.0f : -1.0f;
+    float bow = side * 0.25f * length * ((parallelIndex + 1) / 2);
+    sf::Vector2f control = (p1 + p2) * 0.5f + normal * bow;
+    for (int i = 0; i <= EdgeCurveSegments; ++i)
+    {
+        float t = (float)i / EdgeCurveSegments;
+        points[i] = p1 * ((1 - t) * (1 - t)) + control * (2 * t * (1 - t)) + p2 * (t * t);
+    }
+}
+
+class GraphRenderer : public sf::Drawable
+{
+public:
+    explicit GraphRenderer(const sf::Font* font = nullptr, const VertexStyle& style = VertexStyle())
+        : font(font), style(style), lines(sf::Lines), shapes(sf::Triangles) {}
+
+    // Color of the edges added from now on.
+    void setEdgeColor(sf::Color color) { edgeColor = color; }
+
+    // With culling off every element is drawn at full detail, whatever the view.
+    void setCulling(bool enabled) { culling = enabled; }
+
+    void clear()
+    {
+        vertices.clear();
+        edges.clear();
+        pairCounts.clear();
+        polylines.clear();
+        staticLabels.clear();
+        longEdges.clear();
+        tiles = SpatialGrid(TileSize);
+        lines.clear();
+        shapes.clear();
+        labels.clear();
+        ++version;
+    }
+
+    // Replaces the whole graph; vertices are labelled 1..n.
+    void setGraph(const vector<sf::Vector2f>& positions, const vector<pair<int, int>>& graphEdges)
+    {
+        clear();
+        for (const auto& position : positions)
+            addVertex(position);
+        for (const auto& edge : graphEdges)
+            addEdge(edge.first, edge.second);
+    }
+
+    int addVertex(sf::Vector2f center)
+    {
+        VertexSlot slot;
+        slot.center = center;
+        slot.shapeFirst = shapes.allocate(9 * style.sides);
+        string label = to_string(vertices.size() + 1);
+        slot.labelFirst = appendText(label, center + style.labelOffset, style.labelSize, style.labelColor, slot.labelCount);
+        vertices.push_back(slot);
+        int v = (int)vertices.size() - 1;
+        writeShape(v, style.fill);
+        tiles.setVertex(v, center.x, center.y, center.x, center.y);
+        ++version;
+        return v;
+    }
+
+    // Straight for the first edge between two vertices, bowed for each parallel one, and a
+    // small circle above the vertex for a loop.
+    int addEdge(int u, int v)
+    {
+        EdgeSlot slot;
+        slot.u = u;
+        slot.v = v;
+        slot.parallelIndex = pairCounts[make_pair(min(u, v), max(u, v))]++;
+        bool curved = u == v || slot.parallelIndex > 0;
+        slot.count = curved ? 2 * EdgeCurveSegments : 2;
+        slot.first = lines.allocate(slot.count);
+        slot.color = edgeColor;
+        edges.push_back(slot);
+        int index = (int)edges.size() - 1;
+        vertices[u].incidentEdges.push_back(index);
+        if (v != u)
+            vertices[v].incidentEdges.push_back(index);
+        writeEdge(index);
+        ++version;
+        return index;
+    }
+
+    void setVertexPosition(int v, sf::Vector2f center)
+    {
+        VertexSlot& slot = vertices[v];
+        sf::Vector2f delta = center - slot.center;
+        slot.center = center;
+        for (size_t i = 0; i < 9 * (size_t)style.sides; ++i)
+            shapes.at(slot.shapeFirst + i)->position += delta;
+        shapes.markDirty(slot.shapeFirst, 9 * style.sides);
+        RenderLayer& text = labels[style.labelSize];
+        for (size_t i = 0; i < slot.labelCount; ++i)
+            text.at(slot.labelFirst + i)->position += delta;
+        text.markDirty(slot.labelFirst, slot.labelCount);
+        for (int edge : slot.incidentEdges)
+            writeEdge(edge);
+        tiles.setVertex(v, center.x, center.y, center.x, center.y);
+        ++version;
+    }
+
+    void setEdgeColor(int edge, sf::Color color)
+    {
+        edges[edge].color = color;
+        writeEdge(edge);
+        ++version;
+    }
+
+    // A label at the middle of the edge that moves along with it.
+    void setEdgeLabel(int edge, const string& str, unsigned size, sf::Color color)
+    {
+        EdgeSlot& slot = edges[edge];
+        sf::Vector2f extent = measureText(str, size);
+        slot.labelSize = size;
+        slot.labelFirst = appendText(str, slot.labelAnchor - sf::Vector2f(extent.x / 2, extent.y / 2), size, color, slot.labelCount);
+        ++version;
+    }
+
+    void setVertexColor(int v, sf::Color fill)
+    {
+        const VertexSlot& slot = vertices[v];
+        for (size_t i = 0; i < 3 * (size_t)style.sides; ++i)
+            shapes.at(slot.shapeFirst + i)->color = fill;
+        shapes.markDirty(slot.shapeFirst, 3 * style.sides);
+        ++version;
+    }
+
+    sf::Vector2f vertexPosition(int v) const { return vertices[v].center; }
+    int vertexCount() const { return (int)vertices.size(); }
+
+    // Free-hand strokes that are not tied to any vertex, such as the edges drawn on the board.
+    // Returns an id for setPolylineColor.
+    int addPolyline(const vector<sf::Vector2f>& points, sf::Color color)
+    {
+        size_t count = points.size() < 2 ? 0 : 2 * (points.size() - 1);
+        size_t first = lines.allocate(count);
+        for (size_t i = 0; i + 1 < points.size(); ++i)
+        {
+            *lines.at(first + 2 * i) = sf::Vertex(points[i], color);
+            *lines.at(first + 2 * i + 1) = sf::Vertex(points[i + 1], color);
+        }
+        polylines.emplace_back(first, count);
+        ++version;
+        return (int)polylines.size() - 1;
+    }
+
+    void setPolylineColor(int id, sf::Color color)
+    {
+        size_t first = polylines[id].first, count = polylines[id].second;
+        for (size_t i = 0; i < count; ++i)
+            lines.at(first + i)->color = color;
+        lines.markDirty(first, count);
+        ++version;
+    }
+
+    // A static label centered on `center`.
+    void addLabel(const string& str, sf::Vector2f center, unsigned size, sf::Color color)
+    {
+        sf::Vector2f extent = measureText(str, size);
+        size_t count;
+        size_t first = appendText(str, center - sf::Vector2f(extent.x / 2, extent.y / 2), size, color, count);
+        staticLabels.push_back({ size, first, count });
+        ++version;
+    }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+    {
+        const sf::View& view = target.getView();
+        sf::FloatRect visible(view.getCenter().x - view.getSize().x / 2, view.getCenter().y - view.getSize().y / 2,
+            view.getSize().x, view.getSize().y);
+        float pixelsPerUnit = target.getSize().x * view.getViewport().width / view.getSize().x;
+        bool fullDetail = style.labelSize * pixelsPerUnit >= MinLabelPixels && style.radius * pixelsPerUnit >= MinShapePixels;
+        if (!culling || (fullDetail && contains(visible, graphBounds())))
+        {
+            drawLayers(target, states, lines, shapes, labels);
+            return;
+        }
+        if (cachedVersion != version || cachedPixelsPerUnit != pixelsPerUnit || cachedView.left != visible.left
+            || cachedView.top != visible.top || cachedView.width != visible.width || cachedView.height != visible.height)
+        {
+            collectVisible(visible, pixelsPerUnit);
+            cachedVersion = version;
+            cachedView = visible;
+            cachedPixelsPerUnit = pixelsPerUnit;
+        }
+        drawLayers(target, states, visibleLines, visibleShapes, visibleLabels);
+        visiblePoints.draw(target, states);
+    }
+
+private:
+    static constexpr float TileSize = 64.0f;
+    static constexpr float MinLabelPixels = 6.0f; // smallest readable character size
+    static constexpr float MinShapePixels = 2.5f; // smaller vertices are drawn as points
+    static constexpr float AggregatePixels = 1.0f; // smaller vertices merge their edges
+    static constexpr float AggregateCellPixels = 8.0f;
+
+    struct StaticLabel
+    {
+        unsigned size;
+        size_t first;
+        size_t count;
+    };
+
+    void drawLayers(sf::RenderTarget& target, sf::RenderStates states, const RenderLayer& lineLayer,
+        const RenderLayer& shapeLayer, const map<unsigned, RenderLayer>& labelLayers) const
+    {
+        lineLayer.draw(target, states);
+        shapeLayer.draw(target, states);
+        if (font == nullptr)
+            return;
+        for (const auto& layer : labelLayers)
+        {
+            states.texture = &font->getTexture(layer.first);
+            layer.second.draw(target, states);
+        }
+    }
+
+    static bool contains(const sf::FloatRect& outer, const sf::FloatRect& inner)
+    {
+        return inner.left >= outer.left && inner.top >= outer.top && inner.left + inner.width <= outer.left + outer.width
+            && inner.top + inner.height <= outer.top + outer.height;
+    }
+
+    static bool overlaps(const sf::FloatRect& r, float left, float top, float right, float bottom)
+    {
+        return left <= r.left + r.width && right >= r.left && top <= r.top + r.height && bottom >= r.top;
+    }
+
+    // Bounds of everything drawn, recomputed once per change.
+    sf::FloatRect graphBounds() const
+    {
+        if (boundsVersion == version)
+            return bounds;
+        float left = INFINITY, top = INFINITY, right = -INFINITY, bottom = -INFINITY;
+        auto extend = [&](const RenderLayer& layer) {
+            for (size_t i = 0; i < layer.size(); ++i)
+            {
+                const sf::Vector2f& p = layer.at(i)->position;
+                left = min(left, p.x);
+                top = min(top, p.y);
+                right = max(right, p.x);
+                bottom = max(bottom, p.y);
+            }
+            };
+        extend(lines);
+        extend(shapes);
+        for (const auto& layer : labels)
+            extend(layer.second);
+        bounds = left <= right ? sf::FloatRect(left, top, right - left, bottom - top) : sf::FloatRect();
+        boundsVersion = version;
+        return bounds;
+    }
+
+    // Copies the slots that intersect `visible` into the visible layers, at the level of
+    // detail for the current zoom.
+    void collectVisible(const sf::FloatRect& visible, float pixelsPerUnit) const
+    {
+        visibleLines.clear();
+        visibleShapes.clear();
+        visiblePoints.clear();
+        visibleLabels.clear();
+        bool showLabels = font != nullptr && style.labelSize * pixelsPerUnit >= MinLabelPixels;
+        bool showShapes = style.radius * pixelsPerUnit >= MinShapePixels;
+        bool aggregate = style.radius * pixelsPerUnit < AggregatePixels;
+        float reach = style.radius + style.outlineThickness + 2.0f * style.labelSize;
+
+        // Every edge that crosses the view and fits in a tile has an endpoint within a tile
+        // of it; longer edges are tested one by one
+        vector<int> candidates;
+        if (contains(visible, graphBounds()))
+        {
+            candidates.resize(vertices.size());
+            iota(candidates.begin(), candidates.end(), 0);
+        }
+        else
+        {
+            float margin = TileSize + reach;
+            candidates = tiles.verticesIn(visible.left - margin, visible.top - margin,
+                visible.left + visible.width + margin, visible.top + visible.height + margin);
+        }
+
+        const RenderLayer* vertexLabels = labels.count(style.labelSize) ? &labels.at(style.labelSize) : nullptr;
+        for (int v : candidates)
+        {
+            const VertexSlot& slot = vertices[v];
+            if (!overlaps(visible, slot.center.x - reach, slot.center.y - reach, slot.center.x + reach, slot.center.y + reach))
+                continue;
+            if (showShapes)
+                visibleShapes.append(shapes.at(slot.shapeFirst), 9 * style.sides);
+            else
+            {
+                sf::Vertex point(slot.center, shapes.at(slot.shapeFirst)->color);
+                visiblePoints.append(&point, 1);
+            }
+            if (showLabels && vertexLabels != nullptr)
+                visibleLabels[style.labelSize].append(vertexLabels->at(slot.labelFirst), slot.labelCount);
+        }
+
+        float cell = AggregateCellPixels / pixelsPerUnit;
+        unordered_map<uint64_t, int> merged; // pair of screen cells -> edges between them
+        if (edgeStamp.size() < edges.size())
+            edgeStamp.resize(edges.size(), 0);
+        ++stamp;
+        auto visitEdge = [&](int e) {
+            if (edgeStamp[e] == stamp)
+                return;
+            edgeStamp[e] = stamp;
+            const EdgeSlot& slot = edges[e];
+            if (!overlaps(visible, slot.left, slot.top, slot.right, slot.bottom))
+                return;
+            if (!aggregate)
+            {
+                visibleLines.append(lines.at(slot.first), slot.count);
+                if (showLabels && slot.labelCount > 0)
+                    visibleLabels[slot.labelSize].append(labels.at(slot.labelSize).at(slot.labelFirst), slot.labelCount);
+                return;
+            }
+            if (slot.u == slot.v)
+                return;
+            uint32_t a = cellId(vertices[slot.u].center, cell), b = cellId(vertices[slot.v].center, cell);
+            if (a != b)
+                merged[a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a]++;
+            };
+        for (int v : candidates)
+        {
+            for (int e : vertices[v].incidentEdges)
+            {
+                if (longEdges.count(e) == 0)
+                    visitEdge(e);
+            }
+        }
+        for (int e : longEdges)
+            visitEdge(e);
+        for (const auto& entry : merged)
+        {
+            // One line per pair of cells, more opaque the more edges it stands for
+            sf::Color color = edgeColor;
+            color.a = (sf::Uint8)min(255, 64 + 32 * entry.second);
+            sf::Vertex line[] = { sf::Vertex(cellCenter((uint32_t)(entry.first >> 32), cell), color),
+                sf::Vertex(cellCenter((uint32_t)entry.first, cell), color) };
+            visibleLines.append(line, 2);
+        }
+
+        // Free-hand strokes and static labels are few; they are always kept
+        for (const auto& polyline : polylines)
+            visibleLines.append(lines.at(polyline.first), polyline.second);
+        if (showLabels)
+        {
+            for (const auto& label : staticLabels)
+                visibleLabels[label.size].append(labels.at(label.size).at(label.first), label.count);
+        }
+    }
+
+    // Screen cells are packed as two 16-bit signed coordinates.
+    static uint32_t cellId(sf::Vector2f p, float cell)
+    {
+        int cx = (int)floor(p.x / cell), cy = (int)floor(p.y / cell);
+        return (uint32_t)(uint16_t)cx << 16 | (uint16_t)cy;
+    }
+
+    static sf::Vector2f cellCenter(uint32_t id, float cell)
+    {
+        int cx = (int16_t)(id >> 16), cy = (int16_t)(id & 0xffff);
+        return sf::Vector2f((cx + 0.5f) * cell, (cy + 0.5f) * cell);
+    }
+
+    struct VertexSlot
+    {
+        sf::Vector2f center;
+        size_t shapeFirst = 0;
+        size_t labelFirst = 0;
+        size_t labelCount = 0;
+        vector<int> incidentEdges;
+    };
+
+    struct EdgeSlot
+    {
+        int u = 0, v = 0;
+        int parallelIndex = 0;
+        size_t first = 0;
+        size_t count = 0;
+        sf::Color color;
+        float left = 0, top = 0, right = 0, bottom = 0;
+        sf::Vector2f labelAnchor; // middle of the curve
+        unsigned labelSize = 0;
+        size_t labelFirst = 0;
+        size_t labelCount = 0;
+    };
+
+    // Fill fan followed by the outline ring, both as plain triangles.
+    void writeShape(int v, sf::Color fill)
+    {
+        const VertexSlot& slot = vertices[v];
+        const float pi = 3.14159265f;
+        float outer = style.radius + style.outlineThickness / cos(pi / style.sides);
+        sf::Vertex* out = shapes.at(slot.shapeFirst);
+        for (int i = 0; i < style.sides; ++i)
+        {
+            float a1 = (style.rotation * pi / 180) + 2 * pi * i / style.sides;
+            float a2 = (style.rotation * pi / 180) + 2 * pi * (i + 1) / style.sides;
+            sf::Vector2f d1(cos(a1), sin(a1)), d2(cos(a2), sin(a2));
+            sf::Vector2f inner1 = slot.center + d1 * style.radius, inner2 = slot.center + d2 * style.radius;
+            sf::Vector2f outer1 = slot.center + d1 * outer, outer2 = slot.center + d2 * outer;
+            out[3 * i] = sf::Vertex(slot.center, fill);
+            out[3 * i + 1] = sf::Vertex(inner1, fill);
+            out[3 * i + 2] = sf::Vertex(inner2, fill);
+            sf::Vertex* ring = out + 3 * style.sides + 6 * i;
+            ring[0] = sf::Vertex(inner1, style.outline);
+            ring[1] = sf::Vertex(outer1, style.outline);
+            ring[2] = sf::Vertex(outer2, style.outline);
+            ring[3] = sf::Vertex(inner1, style.outline);
+            ring[4] = sf::Vertex(outer2, style.outline);
+            ring[5] = sf::Vertex(inner2, style.outline);
+        }
+        shapes.markDirty(slot.shapeFirst, 9 * style.sides);
+    }
+
+    void writeEdge(int index)
+    {
+        EdgeSlot& slot = edges[index];
+        edgeCurve(vertices[slot.u].center, vertices[slot.v].center, slot.u == slot.v, slot.parallelIndex, style.radius, curvePoints);
+        sf::Vertex* out = lines.at(slot.first);
+        for (size_t i = 0; i + 1 < curvePoints.size(); ++i)
+        {
+            out[2 * i] = sf::Vertex(curvePoints[i], slot.color);
+            out[2 * i + 1] = sf::Vertex(curvePoints[i + 1], slot.color);
+        }
+        lines.markDirty(slot.first, slot.count);
+
+        // Bounds for culling; edges larger than a tile are tracked separately
+        slot.left = slot.top = INFINITY;
+        slot.right = slot.bottom = -INFINITY;
+        for (const sf::Vector2f& p : curvePoints)
+        {
+            slot.left = min(slot.left, p.x);
+            slot.top = min(slot.top, p.y);
+            slot.right = max(slot.right, p.x);
+            slot.bottom = max(slot.bottom, p.y);
+        }
+        if (slot.right - slot.left > TileSize || slot.bottom - slot.top > TileSize)
+            longEdges.insert(index);
+        else
+            longEdges.erase(index);
+
+        sf::Vector2f anchor = curvePoints.size() == 2 ? (curvePoints[0] + curvePoints[1]) * 0.5f : curvePoints[EdgeCurveSegments / 2];
+        sf::Vector2f delta = anchor - slot.labelAnchor;
+        slot.labelAnchor = anchor;
+        if (slot.labelCount > 0)
+        {
+            RenderLayer& text = labels[slot.labelSize];
+            for (size_t i = 0; i < slot.labelCount; ++i)
+                text.at(slot.labelFirst + i)->position += delta;
+            text.markDirty(slot.labelFirst, slot.labelCount);
+        }
+    }
+
+    sf::Vector2f measureText(const string& str, unsigned size) const
+    {
+        float width = 0;
+        if (font != nullptr)
+        {
+            for (char c : str)
+                width += font->getGlyph((unsigned char)c, size, false).advance;
+        }
+        return sf::Vector2f(width, (float)size);
+    }
+
+    // Glyph quads laid out the way sf::Text does, baseline at topLeft.y + size. Returns the
+    // first vertex of the run in the layer for `size`; count receives its length.
+    size_t appendText(const string& str, sf::Vector2f topLeft, unsigned size, sf::Color color, size_t& count)
+    {
+        RenderLayer& layer = labels.emplace(size, RenderLayer(sf::Triangles)).first->second;
+        count = font != nullptr ? 6 * str.size() : 0;
+        size_t first = layer.allocate(count);
+        if (font == nullptr)
+            return first;
+        float x = topLeft.x;
+        float baseline = topLeft.y + size;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            const sf::Glyph& glyph = font->getGlyph((unsigned char)str[i], size, false);
+            float left = x + glyph.bounds.left, top = baseline + glyph.bounds.top;
+            float right = left + glyph.bounds.width, bottom = top + glyph.bounds.height;
+            float u1 = (float)glyph.textureRect.left, v1 = (float)glyph.textureRect.top;
+            float u2 = u1 + glyph.textureRect.width, v2 = v1 + glyph.textureRect.height;
+            sf::Vertex* quad = layer.at(first + 6 * i);
+            quad[0] = sf::Vertex(sf::Vector2f(left, top), color, sf::Vector2f(u1, v1));
+            quad[1] = sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1));
+            quad[2] = sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2));
+            quad[3] = sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2));
+            quad[4] = sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1));
+            quad[5] = sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2));
+            x += glyph.advance;
+        }
+        return first;
+    }
+
+    const sf::Font* font;
+    VertexStyle style;
+    sf::Color edgeColor = sf::Color::Blue;
+    vector<VertexSlot> vertices;
+    vector<EdgeSlot> edges;
+    map<pair<int, int>, int> pairCounts;
+    vector<pair<size_t, size_t>> polylines; // first vertex and count in `lines`
+    RenderLayer lines;
+    RenderLayer shapes;
+    map<unsigned, RenderLayer> labels; // one per character size, each bound to its glyph page
+    vector<StaticLabel> staticLabels;
+    unordered_set<int> longEdges;
+    vector<sf::Vector2f> curvePoints; // scratch for writeEdge
+    SpatialGrid tiles{ TileSize }; // vertex centers
+    bool culling = true;
+    unsigned long long version = 0;
+
+    // Visible subset, rebuilt when the graph or the view changes
+    mutable RenderLayer visibleLines{ sf::Lines };
+    mutable RenderLayer visibleShapes{ sf::Triangles };
+    mutable RenderLayer visiblePoints{ sf::Points };
+    mutable map<unsigned, RenderLayer> visibleLabels;
+    mutable unsigned long long cachedVersion = ~0ull;
+    mutable sf::FloatRect cachedView;
+    mutable float cachedPixelsPerUnit = 0;
+    mutable sf::FloatRect bounds;
+    mutable unsigned long long boundsVersion = ~0ull;
+    mutable vector<unsigned> edgeStamp;
+    mutable unsigned stamp = 0;
+};
@@ -0,0 +1,441 @@
+#pragma once
+
+// Record and replay of everything that drives a game session: window events, console lines
+// and the random seed. Recording writes them to a compact binary log as they happen; replay
+// feeds a log back in place of the real input, at the recorded pace or as fast as the game
+// takes it, so a drawing session can be repeated exactly and timed. The mouse position is
+// taken from the events in both modes, since the live cursor differs from run to run.
+//
+// Log layout (integers are LEB128 varints, signed ones zigzag-encoded):
+//     "IGDL", version byte, seed as 4 little-endian bytes
+//     then one record per input: microseconds since the previous record, a tag byte and
+//     either a console line (length and bytes) or, for a window index, the event type
+//     byte followed by that event's fields.
+// Event types the game never handles (joystick, touch, sensor) are not recorded.
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class InputLog
+{
+public:
+    enum class Mode
+    {
+        Live,
+        Record,
+        Replay,
+    };
+
+    // Events of one window, for FramePacer::nextEvent and ResultWindow::processEvents.
+    struct WindowEvents
+    {
+        InputLog& log;
+        int windowIndex;
+
+        bool poll(sf::Window& window, sf::Event& event) { return log.pollEvent(window, windowIndex, event); }
+        bool wait(sf::Window& window, sf::Event& event) { return log.waitEvent(window, windowIndex, event); }
+    };
+
+    InputLog() = default;
+    InputLog(const InputLog&) = delete;
+    InputLog& operator=(const InputLog&) = delete;
+
+    ~InputLog()
+    {
+        if (currentMode == Mode::Replay)
+            cout << "Replayed " << recordsReplayed << " inputs in " << sessionClock.getElapsedTime().asSeconds() << " s" << endl;
+    }
+
+    // Starts writing a log; `seed` is stored so a replay seeds its generator the same way.
+    bool startRecording(const string& fileName, unsigned seed)
+    {
+        file.open(fileName, ios::binary);
+        if (!file)
+            return false;
+        file.write(Magic, 4);
+        file.put((char)Version);
+        for (int i = 0; i < 4; ++i)
+            file.put((char)(seed >> (8 * i)));
+        sessionSeed = seed;
+        currentMode = Mode::Record;
+        sinceLastRecord.restart();
+        return true;
+    }
+
+    // Loads a log to play back. With maxSpeed every input is delivered as soon as the game
+    // asks for one instead of after its recorded delay.
+    bool startReplay(const string& fileName, bool maxSpeed)
+    {
+        ifstream in(fileName, ios::binary);
+        data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        if (data.size() < 9 || memcmp(data.data(), Magic, 4) != 0 || data[4] != Version)
+            return false;
+        sessionSeed = 0;
+        for (int i = 0; i < 4; ++i)
+            sessionSeed |= (unsigned)data[5 + i] << (8 * i);
+        position = 9;
+        replayAtMaxSpeed = maxSpeed;
+        currentMode = Mode::Replay;
+        readRecord();
+        sessionClock.restart();
+        sinceLastRecord.restart();
+        return true;
+    }
+
+    Mode mode() const { return currentMode; }
+
+    // The seed given to startRecording, or the one stored in the replayed log.
+    unsigned seed() const { return sessionSeed; }
+
+    WindowEvents events(int windowIndex) { return WindowEvents{ *this, windowIndex }; }
+
+    // Like window.pollEvent. While replaying, the window's own events are discarded except
+    // Closed, so the replay can still be stopped by closing the window; once the log runs
+    // out every window gets Closed.
+    bool pollEvent(sf::Window& window, int windowIndex, sf::Event& event)
+    {
+        if (currentMode != Mode::Replay)
+        {
+            if (!window.pollEvent(event))
+                return false;
+            if (currentMode == Mode::Record && writeEvent(windowIndex, event))
+                trackMouse(windowIndex, event);
+            return true;
+        }
+        sf::Event live;
+        while (window.pollEvent(live))
+        {
+            if (live.type == sf::Event::Closed)
+            {
+                event = live;
+                return true;
+            }
+        }
+        if (finished)
+        {
+            event.type = sf::Event::Closed;
+            return true;
+        }
+        if (pending.tag != windowIndex || !pendingDue())
+            return false;
+        event = pending.event;
+        trackMouse(windowIndex, event);
+        consumeRecord();
+        return true;
+    }
+
+    // Like window.waitEvent. While replaying, returns false instead of blocking when the
+    // next input is not for this window.
+    bool waitEvent(sf::Window& window, int windowIndex, sf::Event& event)
+    {
+        if (currentMode != Mode::Replay)
+        {
+            if (!window.waitEvent(event))
+                return false;
+            if (currentMode == Mode::Record && writeEvent(windowIndex, event))
+                trackMouse(windowIndex, event);
+            return true;
+        }
+        while (!pollEvent(window, windowIndex, event))
+        {
+            if (pending.tag != windowIndex)
+                return false;
+            sleepUntilDue();
+        }
+        return true;
+    }
+
+    // One line of console input without its newline; false at the end of input.
+    bool readLine(string& line)
+    {
+        if (currentMode != Mode::Replay)
+        {
+            if (!getline(cin, line))
+                return false;
+            if (currentMode == Mode::Record)
+            {
+                writeHeader(ConsoleLine);
+                writeVarint(line.size());
+                file.write(line.data(), line.size());
+            }
+            return true;
+        }
+        if (finished || pending.tag != ConsoleLine)
+            return false;
+        while (!pendingDue())
+            sleepUntilDue();
+        line = pending.line;
+        cout << line << endl; // echoed, as if typed
+        consumeRecord();
+        return true;
+    }
+
+    // Mouse position in the window: the live cursor, or the last recorded mouse event.
+    sf::Vector2i mousePosition(const sf::Window& window, int windowIndex) const
+    {
+        if (currentMode == Mode::Live)
+            return sf::Mouse::getPosition(window);
+        return windowIndex < (int)lastMouse.size() ? lastMouse[windowIndex] : sf::Vector2i();
+    }
+
+private:
+    static constexpr char Magic[5] = "IGDL";
+    static constexpr uint8_t Version = 1;
+    static constexpr uint8_t ConsoleLine = 255; // tag of a console line; other tags are window indices
+    static constexpr int64_t MaxSleepMicroseconds = 4000;
+
+    struct Record
+    {
+        int64_t delay = 0;
+        int tag = -1;
+        sf::Event event;
+        string line;
+    };
+
+    void trackMouse(int windowIndex, const sf::Event& event)
+    {
+        if (windowIndex >= (int)lastMouse.size())
+            lastMouse.resize(windowIndex + 1);
+        if (event.type == sf::Event::MouseMoved)
+            lastMouse[windowIndex] = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+        else if (event.type == sf::Event::MouseButtonPressed || event.type == sf::Event::MouseButtonReleased)
+            lastMouse[windowIndex] = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        else if (event.type == sf::Event::MouseWheelScrolled)
+            lastMouse[windowIndex] = sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+    }
+
+    void writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            file.put((char)(value | 0x80));
+            value >>= 7;
+        }
+        file.put((char)value);
+    }
+
+    void writeSigned(int64_t value) { writeVarint((uint64_t)(value << 1) ^ (uint64_t)(value >> 63)); }
+
+    void writeHeader(uint8_t tag)
+    {
+        writeVarint(sinceLastRecord.restart().asMicroseconds());
+        file.put((char)tag);
+    }
+
+    // Returns false for event types that are not recorded.
+    bool writeEvent(int windowIndex, const sf::Event& event)
+    {
+        switch (event.type)
+        {
+        case sf::Event::Closed:
+        case sf::Event::LostFocus:
+        case sf::Event::GainedFocus:
+        case sf::Event::MouseEntered:
+        case sf::Event::MouseLeft:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            return true;
+        case sf::Event::Resized:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            writeVarint(event.size.width);
+            writeVarint(event.size.height);
+            return true;
+        case sf::Event::TextEntered:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            writeVarint(event.text.unicode);
+            return true;
+        case sf::Event::KeyPressed:
+        case sf::Event::KeyReleased:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            writeSigned(event.key.code);
+            file.put((char)(event.key.alt | event.key.control << 1 | event.key.shift << 2 | event.key.system << 3));
+            return true;
+        case sf::Event::MouseMoved:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            writeSigned(event.mouseMove.x);
+            writeSigned(event.mouseMove.y);
+            return true;
+        case sf::Event::MouseButtonPressed:
+        case sf::Event::MouseButtonReleased:
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            file.put((char)event.mouseButton.button);
+            writeSigned(event.mouseButton.x);
+            writeSigned(event.mouseButton.y);
+            return true;
+        case sf::Event::MouseWheelScrolled:
+        {
+            writeHeader((uint8_t)windowIndex);
+            file.put((char)event.type);
+            file.put((char)event.mouseWheelScroll.wheel);
+            char delta[4];
+            memcpy(delta, &event.mouseWheelScroll.delta, 4);
+            file.write(delta, 4);
+            writeSigned(event.mouseWheelScroll.x);
+            writeSigned(event.mouseWheelScroll.y);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // Reading stops at the first truncated or unknown record, which ends the replay.
+    bool readByte(uint8_t& value)
+    {
+        if (position >= data.size())
+            return false;
+        value = data[position++];
+        return true;
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte;
+            if (!readByte(byte))
+                return false;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return true;
+        }
+        return false;
+    }
+
+    bool readSigned(int& value)
+    {
+        uint64_t raw;
+        if (!readVarint(raw))
+            return false;
+        value = (int)(int64_t)((raw >> 1) ^ (~(raw & 1) + 1));
+        return true;
+    }
+
+    void readRecord()
+    {
+        finished = !parseRecord(pending);
+    }
+
+    bool parseRecord(Record& record)
+    {
+        uint64_t delay, value;
+        uint8_t tag, type, byte;
+        if (!readVarint(delay) || !readByte(tag))
+            return false;
+        record.delay = (int64_t)delay;
+        record.tag = tag;
+        if (tag == ConsoleLine)
+        {
+            if (!readVarint(value) || value > data.size() - position)
+                return false;
+            record.line.assign((const char*)data.data() + position, (size_t)value);
+            position += (size_t)value;
+            return true;
+        }
+        if (!readByte(type))
+            return false;
+        sf::Event& event = record.event;
+        event.type = (sf::Event::EventType)type;
+        switch (event.type)
+        {
+        case sf::Event::Closed:
+        case sf::Event::LostFocus:
+        case sf::Event::GainedFocus:
+        case sf::Event::MouseEntered:
+        case sf::Event::MouseLeft:
+            return true;
+        case sf::Event::Resized:
+        {
+            uint64_t width, height;
+            if (!readVarint(width) || !readVarint(height))
+                return false;
+            event.size.width = (unsigned)width;
+            event.size.height = (unsigned)height;
+            return true;
+        }
+        case sf::Event::TextEntered:
+            if (!readVarint(value))
+                return false;
+            event.text.unicode = (uint32_t)value;
+            return true;
+        case sf::Event::KeyPressed:
+        case sf::Event::KeyReleased:
+        {
+            int code;
+            if (!readSigned(code) || !readByte(byte))
+                return false;
+            event.key.code = (sf::Keyboard::Key)code;
+            event.key.alt = byte & 1;
+            event.key.control = byte >> 1 & 1;
+            event.key.shift = byte >> 2 & 1;
+            event.key.system = byte >> 3 & 1;
+            return true;
+        }
+        case sf::Event::MouseMoved:
+            return readSigned(event.mouseMove.x) && readSigned(event.mouseMove.y);
+        case sf::Event::MouseButtonPressed:
+        case sf::Event::MouseButtonReleased:
+            if (!readByte(byte))
+                return false;
+            event.mouseButton.button = (sf::Mouse::Button)byte;
+            return readSigned(event.mouseButton.x) && readSigned(event.mouseButton.y);
+        case sf::Event::MouseWheelScrolled:
+            if (!readByte(byte) || data.size() - position < 4)
+                return false;
+            event.mouseWheelScroll.wheel = (sf::Mouse::Wheel)byte;
+            memcpy(&event.mouseWheelScroll.delta, data.data() + position, 4);
+            position += 4;
+            return readSigned(event.mouseWheelScroll.x) && readSigned(event.mouseWheelScroll.y);
+        default:
+            return false;
+        }
+    }
+
+    // The delay runs from when the previous input was handed over, so time the game spends
+    // elsewhere does not make later inputs arrive early.
+    bool pendingDue() const
+    {
+        return replayAtMaxSpeed || sinceLastRecord.getElapsedTime().asMicroseconds() >= pending.delay;
+    }
+
+    void sleepUntilDue() const
+    {
+        int64_t remaining = pending.delay - sinceLastRecord.getElapsedTime().asMicroseconds();
+        sf::sleep(sf::microseconds(max<int64_t>(0, min(remaining, MaxSleepMicroseconds))));
+    }
+
+    void consumeRecord()
+    {
+        ++recordsReplayed;
+        sinceLastRecord.restart();
+        readRecord();
+    }
+
+    Mode currentMode = Mode::Live;
+    unsigned sessionSeed = 0;
+    ofstream file;
+    vector<uint8_t> data; // the whole replayed log
+    size_t position = 0;
+    Record pending; // next input to replay
+    bool finished = false;
+    bool replayAtMaxSpeed = false;
+    long long recordsReplayed = 0;
+    sf::Clock sinceLastRecord;
+    sf::Clock sessionClock;
+    vector<sf::Vector2i> lastMouse; // per window index
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+// Graph invariants kept up to date while the graph is built one edge at a time, so nothing
+// has to be recomputed when it is finished. Each insertion costs O(deg) amortized:
+//   - degrees and the degree histogram,
+//   - the number of triangles of the underlying simple graph (parallel edges and loops do
+//     not add any),
+//   - connected components, with union-find,
+//   - a Weisfeiler-Leman signature: every vertex is colored by its degree and the multiset
+//     of its neighbors' degrees (one refinement round, the most that can follow an edge
+//     insertion in O(deg)), and the graph signature is an order-independent hash of those
+//     colors. Isomorphic graphs always get the same signature.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class InvariantTracker
+{
+public:
+    explicit InvariantTracker(int numVertices)
+        : numVertices(numVertices), vertexDegrees(numVertices, 0), histogram(1, numVertices), neighbors(numVertices),
+        rowWords((numVertices + 63) / 64), rows((size_t)numVertices * rowWords, 0), parent(numVertices), componentSize(numVertices, 1),
+        components(numVertices), neighborDegreeSum(numVertices, 0), stamp(numVertices, 0)
+    {
+        for (int v = 0; v < numVertices; ++v)
+        {
+            parent[v] = v;
+            signature += mix(color(v));
+        }
+    }
+
+    // Records edge (u, v); a loop if u == v.
+    void addEdge(int u, int v)
+    {
+        // Triangles closed by the first edge between u and v
+        if (u != v && !isAdjacent(u, v))
+        {
+            const vector<int>& smaller = neighbors[u].size() < neighbors[v].size() ? neighbors[u] : neighbors[v];
+            int other = &smaller == &neighbors[u] ? v : u;
+            ++triangleStamp;
+            for (int w : smaller)
+            {
+                if (w != u && w != v && isAdjacent(w, other) && !countedVia(w))
+                    ++triangles;
+            }
+            setAdjacent(u, v);
+        }
+
+        // The colors of u, v and their neighbors change; take them out of the signature
+        ++currentStamp;
+        vector<int>& affected = scratch;
+        affected.clear();
+        auto touch = [&](int w) {
+            if (stamp[w] != currentStamp)
+            {
+                stamp[w] = currentStamp;
+                affected.push_back(w);
+            }
+            };
+        touch(u);
+        touch(v);
+        for (int w : neighbors[u])
+            touch(w);
+        for (int w : neighbors[v])
+            touch(w);
+        for (int w : affected)
+            signature -= mix(color(w));
+
+        // Neighbors see the new degrees of u and v
+        int add = u == v ? 2 : 1;
+        changeDegree(u, add);
+        if (v != u)
+            changeDegree(v, add);
+        neighbors[u].push_back(v);
+        neighbors[v].push_back(u); // a loop lists u twice, once per end
+        neighborDegreeSum[u] += mix(vertexDegrees[v]);
+        neighborDegreeSum[v] += mix(vertexDegrees[u]);
+
+        for (int w : affected)
+            signature += mix(color(w));
+
+        unite(u, v);
+        ++numEdges;
+    }
+
+    int vertexCount() const { return numVertices; }
+    int edgeCount() const { return numEdges; }
+    int degree(int v) const { return vertexDegrees[v]; }
+    // histogram()[d] is the number of vertices of degree d.
+    const vector<int>& degreeHistogram() const { return histogram; }
+    long long triangleCount() const { return triangles; }
+    int componentCount() const { return components; }
+    bool sameComponent(int u, int v) { return find(u) == find(v); }
+    uint64_t wlSignature() const { return signature; }
+
+private:
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t color(int v) const { return mix(mix(vertexDegrees[v]) ^ neighborDegreeSum[v]); }
+
+    bool isAdjacent(int u, int v) const { return rows[(size_t)u * rowWords + v / 64] >> (v % 64) & 1; }
+
+    void setAdjacent(int u, int v)
+    {
+        rows[(size_t)u * rowWords + v / 64] |= uint64_t(1) << (v % 64);
+        rows[(size_t)v * rowWords + u / 64] |= uint64_t(1) << (u % 64);
+    }
+
+    // Parallel edges list a neighbor more than once; count each common neighbor once.
+    bool countedVia(int w)
+    {
+        if (commonStamp.size() < (size_t)numVertices)
+            commonStamp.assign(numVertices, 0);
+        if (commonStamp[w] == triangleStamp)
+            return true;
+        commonStamp[w] = triangleStamp;
+        return false;
+    }
+
+    void changeDegree(int v, int add)
+    {
+        for (int w : neighbors[v])
+            neighborDegreeSum[w] += mix(vertexDegrees[v] + add) - mix(vertexDegrees[v]);
+        histogram[vertexDegrees[v]]--;
+        vertexDegrees[v] += add;
+        if (vertexDegrees[v] >= (int)histogram.size())
+            histogram.resize(vertexDegrees[v] + 1, 0);
+        histogram[vertexDegrees[v]]++;
+    }
+
+    int find(int v)
+    {
+        while (parent[v] != v)
+        {
+            parent[v] = parent[parent[v]]; // path halving
+            v = parent[v];
+        }
+        return v;
+    }
+
+    void unite(int u, int v)
+    {
+        u = find(u);
+        v = find(v);
+        if (u == v)
+            return;
+        if (componentSize[u] < componentSize[v])
+            swap(u, v);
+        parent[v] = u;
+        componentSize[u] += componentSize[v];
+        --components;
+    }
+
+    int numVertices;
+    int numEdges = 0;
+    vector<int> vertexDegrees;
+    vector<int> histogram;
+    vector<vector<int>> neighbors; // one entry per edge end, in insertion order
+    int rowWords;
+    vector<uint64_t> rows; // adjacency bits of the underlying simple graph
+    long long triangles = 0;
+    vector<int> parent;
+    vector<int> componentSize;
+    int components;
+    vector<uint64_t> neighborDegreeSum; // sum of mix(degree) over neighbors, a multiset hash
+    uint64_t signature = 0;
+    vector<unsigned> stamp;
+    unsigned currentStamp = 0;
+    vector<unsigned> commonStamp;
+    unsigned triangleStamp = 0;
+    vector<int> scratch;
+};
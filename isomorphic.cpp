@@ -1,35 +1,31 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <vector>
-#include <unordered_set>
 #include <algorithm>
 #include <numeric>
 #include <random>
+#include <future>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include "graph_catalog.h"
+#include "assets.h"
+#include "graph_renderer.h"
+#include "force_layout.h"
+#include "spatial_index.h"
+#include "board_graph.h"
+#include "invariant_tracker.h"
+#include "puzzle_speculator.h"
+#include "camera.h"
+#include "frame_pacer.h"
+#include "result_window.h"
+#include "trace.h"
+#include "input_log.h"
+#include "graph_io.h"
 
 using namespace std;
 using namespace sf;
 
-struct Dot
-{
-    RectangleShape shape;
-    bool isDragging = false;
-    bool isConnected = false;
-    vector<VertexArray> curves;
-    Text label; // Number label for the dot
-};
-
-struct Edge
-{
-    VertexArray line;
-    Text label; // Number label for the edge
-};
-
-Vector2f calculateMidpoint(const Vector2f& startPos, const Vector2f& endPos)
-{
-    return Vector2f((startPos.x + endPos.x) / 2, (startPos.y + endPos.y) / 2 + 50);
-}
-
-
 void sortVerticesByDegree(const vector<int>& degrees, vector<int>& sortedVertices)
 {
     vector<pair<int, int>> vertexDegrees;
@@ -48,160 +44,142 @@ void sortVerticesByDegree(const vector<int>& degrees, vector<int>& sortedVertice
     }
 }
 
+// Parses a line holding one integer and nothing after it, as `cin >> value` followed by a
+// check for the newline did.
+bool parseInteger(const string& line, int& value)
+{
+    istringstream in(line);
+    return (in >> value) && in.peek() == EOF;
+}
+
 const int DotSize = 20;
 const int DotSpacing = 35;
 const int MaxX = 800;
 const int MaxY = 600;
+const unsigned FrameRate = 60; // while dragging, drawing an edge or animating a layout
+// With --save-graphs, appended to in the working directory
+const char* const DrawnGraphsFile = "drawn_graphs.s6"; // every graph the user finishes
+const char* const PuzzlesFile = "puzzles.s6";         // the two random graphs of each puzzle
 
-class Line {
-public:
-    Vector2f p1, p2;
-    bool isSelected;
-
-    Line(Vector2f point1, Vector2f point2, bool selected)
-        : p1(point1), p2(point2), isSelected(selected) {}
-
-    void draw(RenderWindow& window) const {
-        Color color = isSelected ? Color::Red : Color::Blue;
-        Vertex line[] = {
-           Vertex(p1, color),
-            Vertex(p2, color)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
-};
-
-void drawGraph(RenderWindow& window, const vector<Vector2f>& dots, const vector<Line>& lines) {
-    for (const auto& dot : dots) {
-        CircleShape circle(DotSize / 2);
-        circle.setFillColor(Color::Red);
-        circle.setOutlineColor(Color::White);
-        circle.setOutlineThickness(1.0f);
-        circle.setPosition(dot.x - DotSize / 2, dot.y - DotSize / 2);
-        window.draw(circle);
-    }
-
-    for (const auto& line : lines) {
-        line.draw(window);
-    }
-
-    int i = 1;
-    Font font;
-    font.loadFromFile("C:/Users/Acer/Downloads/cooper.ttf"); // Change this to the path of a font file.
-
-    for (const auto& dot : dots) {
-        Text text(to_string(i++), font, 14);
-        text.setFillColor(Color::Black);
-        text.setPosition(dot.x - 6, dot.y - 10);
-        window.draw(text);
-    }
+// Result windows: red circles with the vertex number on top, like the original drawGraph
+VertexStyle resultVertexStyle()
+{
+    VertexStyle style;
+    style.radius = DotSize / 2;
+    style.fill = Color::Red;
+    style.outline = Color::White;
+    style.outlineThickness = 1.0f;
+    style.labelOffset = Vector2f(-6, -10);
+    return style;
 }
 
-vector<vector<int>> generateRandomGraph(int numVertices, int numEdges)
+// Drawing board: yellow 20x20 squares with a thick white outline
+VertexStyle boardVertexStyle()
 {
-    random_device rd;
-    mt19937 gen(rd());
-
-    vector<vector<int>> adjacencyMatrix(numVertices, vector<int>(numVertices, 0));
-
-    while (numEdges > 0)
-    {
-        int v1 = uniform_int_distribution<>(0, numVertices - 1)(gen);
-        int v2 = uniform_int_distribution<>(0, numVertices - 1)(gen);
-
-        // Ensure we don't create self-loops or duplicate edges
-        if (v1 != v2 && adjacencyMatrix[v1][v2] == 0)
-        {
-            adjacencyMatrix[v1][v2] = 1;
-            adjacencyMatrix[v2][v1] = 1;
-            numEdges--;
-        }
-    }
-
-    return adjacencyMatrix;
+    VertexStyle style;
+    style.radius = DotSize / 2 * sqrt(2.0f);
+    style.sides = 4;
+    style.rotation = 45.0f;
+    style.fill = Color::Yellow;
+    style.outline = Color::White;
+    style.outlineThickness = 5.0f;
+    style.labelOffset = Vector2f(-5, -8);
+    return style;
 }
 
-// Function to shuffle vertices randomly while preserving the number of edges
-void shuffleVerticesWithSameEdges(vector<vector<int>>& adjacencyMatrix)
+// usage: isomorphic [--record file | --replay file [--max-speed] [--offscreen]]
+// --record saves the session's window events, console input and random seed; --replay plays
+// them back instead of reading the mouse, keyboard and console, at the recorded pace or
+// with --max-speed as fast as the game takes them, optionally drawing into hidden
+// offscreen targets.
+int main(int argc, char** argv)
 {
-    int numVertices = adjacencyMatrix.size();
-
-    // Create a random permutation of indices
-    vector<int> permutation(numVertices);
-    for (int i = 0; i < numVertices; ++i)
+    // Set ISOMORPHIC_TRACE to a file name to record a Chrome trace of the session
+    TraceSession traceSession(getenv("ISOMORPHIC_TRACE"));
+    string recordFile, replayFile;
+    bool maxSpeed = false, offscreen = false, saveGraphs = false;
+    for (int i = 1; i < argc; ++i)
     {
-        permutation[i] = i;
+        string argument = argv[i];
+        if (argument == "--record" && i + 1 < argc)
+            recordFile = argv[++i];
+        else if (argument == "--replay" && i + 1 < argc)
+            replayFile = argv[++i];
+        else if (argument == "--max-speed")
+            maxSpeed = true;
+        else if (argument == "--offscreen")
+            offscreen = true;
+        else if (argument == "--save-graphs")
+            saveGraphs = true;
+        else
+        {
+            cout << "usage: isomorphic [--record file | --replay file [--max-speed] [--offscreen]] [--save-graphs]" << endl;
+            return 1;
+        }
     }
-    shuffle(permutation.begin(), permutation.end(), std::mt19937(std::random_device()()));
 
-    // Create a copy of the original adjacency matrix to store the shuffled version
-    vector<vector<int>> shuffledAdjacencyMatrix(numVertices, vector<int>(numVertices, 0));
+    int numVertices, numEdges;
+    RenderWindow window(VideoMode(800, 600), "Graph Drawing");
 
-    // Transfer edges based on the permutation
-    for (int i = 0; i < numVertices; ++i)
+    random_device rd; // Obtain a random seed from the operating system
+    unsigned seed = rd();
+    InputLog input;
+    if (!replayFile.empty())
     {
-        for (int j = i + 1; j < numVertices; ++j)
+        if (!input.startReplay(replayFile, maxSpeed))
         {
-            if (adjacencyMatrix[permutation[i]][permutation[j]] == 1)
-            {
-                shuffledAdjacencyMatrix[i][j] = 1;
-                shuffledAdjacencyMatrix[j][i] = 1;
-            }
+            cout << "Failed to read input log " << replayFile << endl;
+            return 1;
         }
+        seed = input.seed();
     }
-
-    // Replace the original adjacency matrix with the shuffled one
-    adjacencyMatrix = std::move(shuffledAdjacencyMatrix);
-}
-vector<int> calculateDegrees(const vector<vector<int>>& adjacencyMatrix) {
-    int numVertices = adjacencyMatrix.size();
-    vector<int> degrees(numVertices, 0);
-
-    for (int i = 0; i < numVertices; ++i) {
-        for (int j = 0; j < numVertices; ++j) {
-            degrees[i] += adjacencyMatrix[i][j];
-        }
+    else if (!recordFile.empty() && !input.startRecording(recordFile, seed))
+    {
+        cout << "Failed to create input log " << recordFile << endl;
+        return 1;
     }
+    offscreen = offscreen && input.mode() == InputLog::Mode::Replay;
+    mt19937 gen(seed); // Create the random number generator using the random seed
 
-    return degrees;
-}
-bool isIsomorphic(const vector<int>& degrees1, const vector<int>& degrees2) {
-    if (degrees1.size() != degrees2.size()) {
-        return false;
+    // Everything is drawn to `screen`: the window, or a texture of the same size while an
+    // offscreen replay keeps the window hidden
+    RenderTexture offscreenTexture;
+    if (offscreen)
+    {
+        window.setVisible(false);
+        offscreenTexture.create(800, 600);
     }
-
-    vector<int> sortedDegrees1 = degrees1;
-    vector<int> sortedDegrees2 = degrees2;
-    sort(sortedDegrees1.begin(), sortedDegrees1.end());
-    sort(sortedDegrees2.begin(), sortedDegrees2.end());
-
-    return sortedDegrees1 == sortedDegrees2;
-}
-
-int main()
-{
-    int numVertices, numEdges;
-    vector<Edge> randomEdges1, randomEdges2;
-    RenderWindow window(VideoMode(800, 600), "Graph Drawing");
-
-    random_device rd; // Obtain a random seed from the operating system
-    mt19937 gen(rd()); // Create the random number generator using the random seed
+    RenderTarget& screen = offscreen ? (RenderTarget&)offscreenTexture : window;
+    auto present = [&]() {
+        if (offscreen)
+            offscreenTexture.display();
+        else
+            window.display();
+        };
+    // Precomputed classes of every small simple graph, built offline by catalog_builder
+    GraphCatalog catalog;
+    if (!catalog.open("graph_catalog.bin"))
+        cout << "Graph catalog not found, run catalog_builder to enable catalog lookups" << endl;
+    // Fonts and textures are loaded once here; paths can be changed in assets.cfg
+    AssetManager assets;
+    assets.loadConfig("assets.cfg");
     // Loading screen
-    Font font;
-    if (!font.loadFromFile("C:/Users/Acer/Downloads/cooper.ttf"))
+    const Font* fontAsset = assets.font("font");
+    if (!fontAsset)
     {
         cout << "Failed to load font" << endl;
         return 1;
     }
+    const Font& font = *fontAsset;
 
-    Texture backgroundTexture;
-    if (!backgroundTexture.loadFromFile("C:/Users/Acer/Downloads/background.gif"))
+    const Texture* backgroundTexture = assets.texture("background");
+    if (!backgroundTexture)
     {
         cout << "Failed to load background image" << endl;
         return 1;
     }
 
-    Sprite background(backgroundTexture);
+    Sprite background(*backgroundTexture);
     background.setScale(1.0f, 1.0f);
 
     Text loadingText;
@@ -242,11 +220,16 @@ int main()
         loadingDots[i].setFillColor(Color::White);
         loadingDots[i].setPosition(window.getSize().x / 2 - (dotSpacing * (numDots - 1)) / 2 + dotSpacing * i, dotY);
     }
+    // Redrawn only when the dots rotate or the window needs repainting
+    FramePacer loadingPacer(FrameRate);
     while (loading)
     {
+        TRACE_SCOPE("loading frame");
         Event event;
-        while (window.pollEvent(event))
+        while (loadingPacer.nextEvent(window, event, input.events(0)))
         {
+            if (event.type != Event::MouseMoved)
+                loadingPacer.invalidate();
             if (event.type == Event::Closed)
             {
                 window.close();
@@ -254,7 +237,7 @@ int main()
             }
             else if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left)
             {
-                Vector2f mousePos = Vector2f(Mouse::getPosition(window));
+                Vector2f mousePos = Vector2f(input.mousePosition(window, 0));
                 if (startButton.getGlobalBounds().contains(mousePos))
                 {
                     loading = false;
@@ -270,29 +253,42 @@ int main()
         {
             loadingAnimationTimer = 0.0f;
             rotate(loadingDots.begin(), loadingDots.begin() + 1, loadingDots.end());
+            loadingPacer.invalidate();
         }
+        loadingPacer.scheduleIn(seconds(loadingAnimationDuration - loadingAnimationTimer));
+        if (!loadingPacer.needsRedraw())
+            continue;
 
-        window.clear();
-
-        window.draw(background);
+        {
+            TRACE_SCOPE("draw");
+            screen.clear();
 
-        for (const auto& dot : loadingDots)
-            window.draw(dot);
+            screen.draw(background);
 
-        window.draw(loadingText);
-        window.draw(startButton);
-        window.draw(startButtonText);
+            for (const auto& dot : loadingDots)
+                screen.draw(dot);
 
-        window.display();
+            screen.draw(loadingText);
+            screen.draw(startButton);
+            screen.draw(startButtonText);
+        }
+        {
+            TRACE_SCOPE("display");
+            present();
+        }
+        loadingPacer.frameDrawn();
     }
 
     if (gameStarted)
     {
+        string inputLine;
         cout << "Enter the number of vertices(4-10): ";
-        while (!(cin >> numVertices) || numVertices < 4 || numVertices > 10 || cin.peek() != '\n')
+        for (;;)
         {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            if (!input.readLine(inputLine))
+                return 0;
+            if (parseInteger(inputLine, numVertices) && numVertices >= 4 && numVertices <= 10)
+                break;
             cout << "Invalid Input! Please re-enter: ";
         }
 
@@ -301,47 +297,93 @@ int main()
         int maxEdges = min(numVertices * (numVertices - 1) / 2, 10); // Limit the maxEdges to 10 for 10 vertices
 
         cout << "Enter the number of edges(" << minEdges << "-" << maxEdges << "): ";
-        while (!(cin >> numEdges) || numEdges < minEdges || numEdges > maxEdges || cin.peek() != '\n')
+        for (;;)
         {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            if (!input.readLine(inputLine))
+                return 0;
+            if (parseInteger(inputLine, numEdges) && numEdges >= minEdges && numEdges <= maxEdges)
+                break;
             cout << "Invalid Input! Please re-enter: ";
         }
 
-        vector<Dot> dots(numVertices);
-        vector<Edge> edges;
-        vector<unordered_set<int>> connectedDots(numVertices);
-        vector<int> degrees(numVertices, 0); // Track the degree of each vertex
+        // The drawn graph; vertices are numbered 0..n-1 and edges in drawing order
+        BoardGraph boardGraph;
+        const vector<int>& degrees = boardGraph.degrees();
+        const vector<pair<int, int>>& userEdges = boardGraph.edges(); // loops as (v, v)
+        // Invariants follow every edge, and the distractors are generated as soon as only
+        // the last edge is missing
+        InvariantTracker invariants(numVertices);
+        PuzzleSpeculator speculator(numVertices, 4, (unsigned)gen());
 
         bool drawingMode = true;
         Vector2f startPos;
         Vector2f endPos;
         bool isDrawing = false;
         bool loopMode = false; // Flag for loop creation mode
-        int numDrawnEdges = 0;
 
         // Set initial positions of dots manually or based on a pattern
         const float initialX = 100.0f;
         const float initialY = 100.0f;
         const float spacing = 35.0f;
         for (int i = 0; i < numVertices; ++i)
-        {
-            dots[i].shape.setSize(Vector2f(20, 20)); // Set the size of the RectangleShape
-            dots[i].shape.setFillColor(Color::Yellow);
-            dots[i].shape.setOutlineThickness(5); // Set the thickness of the edges
-            dots[i].shape.setPosition(initialX + spacing * i, initialY);
-            // Create the number label
-            dots[i].label.setFont(font);
-            dots[i].label.setString(to_string(i + 1)); // Set the label text to the vertex number
-            dots[i].label.setCharacterSize(14);
-            dots[i].label.setFillColor(Color::Black);
-            // Set the position of the label relative to the dot's position            dots[i].label.setPosition(dots[i].shape.getPosition() + Vector2f(5, 2));
-        }
+            boardGraph.addVertex(initialX + spacing * i + DotSize / 2, initialY + DotSize / 2);
+        // Everything on the board is drawn in a few batches, shaped from boardGraph
+        GraphRenderer board(&font, boardVertexStyle());
+        board.setEdgeColor(Color::Cyan);
+        for (int i = 0; i < numVertices; ++i)
+            board.addVertex(Vector2f(boardGraph.x(i), boardGraph.y(i)));
+        // Grid over the dot squares and edge curves, so clicks do not scan every dot
+        SpatialGrid boardIndex(2 * DotSpacing);
+        const float dotReach = DotSize / 2 + 5; // half the square plus its outline
+        auto indexDot = [&](int i) {
+            boardIndex.setVertex(i, boardGraph.x(i) - dotReach, boardGraph.y(i) - dotReach, boardGraph.x(i) + dotReach, boardGraph.y(i) + dotReach);
+            };
+        for (int i = 0; i < numVertices; ++i)
+            indexDot(i);
+        vector<Vector2f> curve;
+        auto indexEdge = [&](int e) {
+            int u = boardGraph.endpoints(e).first, v = boardGraph.endpoints(e).second;
+            edgeCurve(Vector2f(boardGraph.x(u), boardGraph.y(u)), Vector2f(boardGraph.x(v), boardGraph.y(v)),
+                boardGraph.kind(e) == EdgeKind::Loop, boardGraph.parallelIndex(e), boardVertexStyle().radius, curve);
+            boardIndex.removeSegments(e);
+            for (size_t i = 0; i + 1 < curve.size(); ++i)
+                boardIndex.addSegment(e, curve[i].x, curve[i].y, curve[i + 1].x, curve[i + 1].y);
+            };
+        // The first edge between two dots is straight, further ones are curved and loops
+        // are circles; every edge is labelled with its number
+        auto addBoardEdge = [&](int u, int v) {
+            int e = boardGraph.addEdge(u, v);
+            board.addEdge(u, v);
+            board.setEdgeLabel(e, to_string(e + 1), 12, Color::Red);
+            indexEdge(e);
+            invariants.addEdge(u, v);
+            speculator.update(userEdges, numEdges);
+            cout << "Number of edges drawn: " << boardGraph.numEdges() << " (" << invariants.componentCount()
+                << " components, " << invariants.triangleCount() << " triangles)" << endl;
+            };
+        vector<int> draggedDots;
+        int selectedEdge = -1;
+        // Wheel zooms the board and the right button pans it; mouse positions below are in
+        // board coordinates
+        Camera boardCamera(window, Mouse::Right);
+        Text instructionText;
+        instructionText.setFont(font);
+        instructionText.setString("INSTRUCTION:  Press the (SPACEBAR) to Switch to Move the Vertices\nor to Draw Edges. Press (L) and Click the Right Border of the Vertex\nto Create a Loop. Take Note That The Last Edge Shouldn't be a Loop.");
+        instructionText.setCharacterSize(20);
+        instructionText.setFillColor(Color::White);
+        instructionText.setPosition(10, 10);
+        // The board is redrawn after edits and view changes, and every frame only while a dot
+        // is dragged or an edge is being drawn
+        FramePacer boardPacer(FrameRate);
         while (window.isOpen())
         {
+            TRACE_SCOPE("board frame");
             Event event;
-            while (window.pollEvent(event))
+            while (boardPacer.nextEvent(window, event, input.events(0)))
             {
+                TRACE_SCOPE("handle event");
+                if (boardCamera.handleEvent(event) || event.type != Event::MouseMoved)
+                    boardPacer.invalidate();
                 if (event.type == Event::Closed)
                     window.close();
                 else if (event.type == Event::KeyPressed && event.key.code == Keyboard::Space)
@@ -358,56 +400,41 @@ int main()
                 {
                     if (drawingMode && !loopMode)
                     {
-                        startPos = Vector2f(Mouse::getPosition(window));
+                        startPos = boardCamera.toWorld(input.mousePosition(window, 0));
                         endPos = startPos;
                         isDrawing = true;
                     }
                     else if (loopMode) // Loop creation mode
                     {
-                        Vector2f mousePos = Vector2f(Mouse::getPosition(window));
-                        if (numDrawnEdges < numEdges)
+                        Vector2f mousePos = boardCamera.toWorld(input.mousePosition(window, 0));
+                        if (boardGraph.numEdges() < numEdges)
                         {
                             // Check if any dot is clicked
-                            for (auto& dot : dots)
-                            {
-                                if (dot.shape.getGlobalBounds().contains(mousePos))
-                                {
-                                    // Create a curved line that serves as a loop for the clicked vertex
-                                    VertexArray loop(LinesStrip, 3);
-                                    loop[0].position = dot.shape.getPosition();
-                                    loop[0].color = Color::Cyan;
-                                    loop[1].position = calculateMidpoint(dot.shape.getPosition(), mousePos);
-                                    loop[1].color = Color::Cyan;
-                                    loop[2].position = mousePos;
-                                    loop[2].color = Color::Cyan;                                dot.curves.push_back(loop);
-                                    dot.isConnected = true; // Mark the dot as connected to form a loop
-                                    // Create the label for the edge (loop)
-                                    Text label;
-                                    label.setFont(font);                                 label.setString(to_string(numDrawnEdges + 1)); // Set the label text to the edge number
-                                    label.setCharacterSize(12);                                    label.setFillColor(Color::Red);
-                                    Vector2f labelPosition = calculateMidpoint(dot.shape.getPosition(), mousePos);
-                                    labelPosition.x -= label.getGlobalBounds().width / 2;
-                                    labelPosition.y -= label.getGlobalBounds().height / 2;                                  label.setPosition(labelPosition);
-                                    edges.push_back({ loop, label });
-                                    numDrawnEdges++;                                    degrees[dot.label.getString()[0] - '1'] += 2; // Increment the degree of the vertex
-                                    cout << "Number of edges drawn: " << numDrawnEdges << endl;
-                                    break; // Only one loop allowed at a time, so exit the loop after creating the loop.
-                                }
-                            }
+                            int clicked = boardIndex.vertexAt(mousePos.x, mousePos.y);
+                            if (clicked != -1)
+                                addBoardEdge(clicked, clicked);
                         }
                     }
                     else
                     {
-                        Vector2f mousePos = Vector2f(Mouse::getPosition(window));
+                        Vector2f mousePos = boardCamera.toWorld(input.mousePosition(window, 0));
 
                         // Check if any dot is clicked
-                        for (auto& dot : dots)
+                        draggedDots = boardIndex.verticesAt(mousePos.x, mousePos.y);
+                        for (int i : draggedDots)
+                            board.setVertexColor(i, Color::Red); // Highlight the dot being dragged
+                        // Otherwise pick the edge under the cursor
+                        int picked = draggedDots.empty() ? boardIndex.segmentAt(mousePos.x, mousePos.y, 6.0f) : -1;
+                        if (picked != selectedEdge)
                         {
-                            if (dot.shape.getGlobalBounds().contains(mousePos))
+                            if (selectedEdge != -1)
+                                board.setEdgeColor(selectedEdge, Color::Cyan);
+                            if (picked != -1)
                             {
-                                dot.isDragging = true;
-                                dot.shape.setFillColor(Color::Red); // Highlight the dot being dragged
+                                board.setEdgeColor(picked, Color::Red);
+                                cout << "Edge " << picked + 1 << " selected" << endl;
                             }
+                            selectedEdge = picked;
                         }
                     }
                 }
@@ -415,116 +442,79 @@ int main()
                 {
                     if (drawingMode && isDrawing)
                     {
-                        endPos = Vector2f(Mouse::getPosition(window));
-                        int startDot = -1;
-                        int endDot = -1;
-                        for (int i = 0; i < numVertices; ++i)
-                        {
-                            if (dots[i].shape.getGlobalBounds().contains(startPos))
-                            {
-                                startDot = i;
-                            }
-                            else if (dots[i].shape.getGlobalBounds().contains(endPos))
-                            {
-                                endDot = i;
-                            }
-                        }
+                        endPos = boardCamera.toWorld(input.mousePosition(window, 0));
+                        int startDot = boardIndex.vertexAt(startPos.x, startPos.y);
+                        int endDot = boardIndex.vertexAt(endPos.x, endPos.y);
                         if (startDot != -1 && endDot != -1 && startDot != endDot)
-                        {
-                            // Check if the dots are already connected or if the same dots are connected multiple times
-                            if (connectedDots[startDot].count(endDot) == 0 && connectedDots[endDot].count(startDot) == 0)
-                            {
-                                VertexArray line(Lines, 2);
-                                line[0].position = startPos;
-                                line[1].position = endPos;
-                                line[0].color = Color::Cyan;
-                                line[1].color = Color::Cyan;
-                                edges.push_back({ line });
-                                // Create the label for the edge
-                                Text label;
-                                label.setFont(font);                                label.setString(to_string(numDrawnEdges + 1)); // Set the label text to the edge number
-                                label.setCharacterSize(12);                                label.setFillColor(Color::Red);
-                                // Set the position of the label closer to the edge
-                                Vector2f labelPosition = calculateMidpoint(startPos, endPos);
-                                labelPosition.x -= label.getGlobalBounds().width / 2;
-                                labelPosition.y -= label.getGlobalBounds().height / 2;                               label.setPosition(labelPosition);
-                                edges.back().label = label;                              connectedDots[startDot].insert(endDot);                               connectedDots[endDot].insert(startDot);
-                                numDrawnEdges++;
-                                // Increment the degree of each vertex involved in the line
-                                degrees[startDot]++;
-                                degrees[endDot]++;
-                                cout << "Number of edges drawn: " << numDrawnEdges << endl;
-                            }
-                            else if (startDot != endDot && connectedDots[startDot].count(endDot) > 0 && connectedDots[endDot].count(startDot) > 0)
-                            {
-                                // Create a curved line between already connected vertices
-                                VertexArray curve(LinesStrip, 3);
-                                curve[0].position = startPos;
-                                curve[0].color = Color::Cyan;
-                                curve[1].position = calculateMidpoint(startPos, endPos);
-                                curve[1].color = Color::Cyan;
-                                curve[2].position = endPos;
-                                curve[2].color = Color::Cyan;                                dots[startDot].curves.push_back(curve);                                dots[endDot].curves.push_back(curve);
-                                // Create the label for the edge
-                                Text label;
-                                label.setFont(font);                                label.setString(to_string(numDrawnEdges + 1)); // Set the label text to the edge number
-                                label.setCharacterSize(12);                               label.setFillColor(Color::Red);
-                                // Set the position of the label closer to the edge
-                                Vector2f labelPosition = calculateMidpoint(startPos, endPos);
-                                labelPosition.x -= label.getGlobalBounds().width / 2;
-                                labelPosition.y -= label.getGlobalBounds().height / 2;                              label.setPosition(labelPosition);
-                                edges.push_back({ curve, label });
-                                // Update the degree count for the same dots                                connectedDots[startDot].erase(endDot);                                connectedDots[endDot].erase(startDot);                                connectedDots[startDot].insert(startDot);                                connectedDots[endDot].insert(endDot);
-                                numDrawnEdges++;
-                                // Increment the degree of each vertex involved in the line
-                                degrees[startDot]++;
-                                degrees[endDot]++;
-                                cout << "Number of edges drawn: " << numDrawnEdges << endl;
-                            }
-                        }
+                            addBoardEdge(startDot, endDot);
                         isDrawing = false;
-                        if (numDrawnEdges == numEdges)
+                        if (boardGraph.numEdges() == numEdges)
                         {
                             cout << "Graph drawn successfully" << endl;
+                            // Drawn graphs are kept in sparse6, which holds loops too
+                            if (saveGraphs && saveGraph(DrawnGraphsFile, GraphFormat::Sparse6, numVertices, userEdges))
+                                cout << "Graph saved to " << DrawnGraphsFile << endl;
+                            // Same-degree-sequence distractors, usually generated already
+                            future<PuzzleSpeculator::Distractors> distractorBatch = speculator.take(userEdges);
                             vector<int> sortedVertices;
                             sortVerticesByDegree(degrees, sortedVertices);
+                            cout << "User`s Graph has " << invariants.componentCount() << " connected components and "
+                                << invariants.triangleCount() << " triangles" << endl;
                             cout << "Sorted vertices by degree in ascending order (User`s Graph): \n";
                             for (const auto& vertex : sortedVertices)
                             {
                                 cout << "Vertex " << vertex + 1 << ": Degree " << degrees[vertex] << endl;
                             }
                             cout << "------------------------------------------------------------------ \n";
-                            cout << "Press Enter to generate random graphs..." << endl;
-                            cout << "------------------------------------------------------------------ \n";
-                            cin.ignore(); // Ignore any remaining newline character from previous input
-                            cin.get();
-                            RenderWindow window1(VideoMode(800, 600), "Random Graph 1");
-                            RenderWindow window2(VideoMode(800, 600), "Random Graph 2");
-                            vector<vector<int>> adjacencyMatrix1 = generateRandomGraph(numVertices, numEdges);
-                            shuffleVerticesWithSameEdges(adjacencyMatrix1); // Shuffle the vertices while preserving the edges
-                                                        // Create the dots for the first random graph
-                            vector<Vector2f> graph1Dots;
-                            for (int i = 0; i < numVertices; ++i)
+                            CsrGraph userGraph = buildCsrGraph(numVertices, userEdges);
+                            // Every automorphism gives another valid answer, so the group order is the
+                            // number of mappings onto any isomorphic copy; its orbits are the vertices
+                            // no answer can tell apart
+                            AutomorphismGroup symmetry = automorphismGroup(userGraph);
+                            cout << "There are ";
+                            if (symmetry.order < 1e18)
+                                cout << (long long)symmetry.order;
+                            else
+                                cout << symmetry.order;
+                            cout << " valid mappings onto a graph isomorphic to the User`s Graph" << endl;
+                            for (int v = 0; v < numVertices; ++v)
                             {
-                                int x = uniform_int_distribution<>(DotSpacing, MaxX - DotSpacing)(gen);
-                                int y = uniform_int_distribution<>(DotSpacing, MaxY - DotSpacing)(gen);
-                                graph1Dots.push_back(Vector2f(x, y));
+                                if (symmetry.orbits[v] != v)
+                                    continue;
+                                vector<int> orbit;
+                                for (int w = v; w < numVertices; ++w)
+                                    if (symmetry.orbits[w] == v)
+                                        orbit.push_back(w);
+                                if (orbit.size() < 2)
+                                    continue;
+                                cout << "Structurally equivalent vertices:";
+                                for (int w : orbit)
+                                    cout << " " << w + 1;
+                                cout << endl;
                             }
-
-                            // Create the lines for the first random graph
-                            vector<Line> graph1Lines;
-                            for (int i = 0; i < numVertices; ++i)
+                            cout << "------------------------------------------------------------------ \n";
+                            CatalogRecord userRecord;
+                            if (catalog.isOpen() && makeCatalogRecord(userGraph, userRecord) && catalog.find(userRecord))
                             {
-                                for (int j = i + 1; j < numVertices; ++j)
-                                {
-                                    if (adjacencyMatrix1[i][j] == 1)
-                                    {
-                                        graph1Lines.push_back(Line(graph1Dots[i], graph1Dots[j], false));
-                                    }
-                                }
+                                auto group = catalog.sameDegreeSequence(userRecord);
+                                auto sameSize = catalog.withSize(numVertices, userRecord.numEdges);
+                                cout << "User`s Graph has " << userRecord.automorphismCount << " automorphisms" << endl;
+                                cout << group.second - group.first << " of the " << sameSize.second - sameSize.first
+                                    << " non-isomorphic graphs with " << numVertices << " vertices and " << (int)userRecord.numEdges
+                                    << " edges share its degree sequence" << endl;
+                                cout << "------------------------------------------------------------------ \n";
                             }
-
-                            vector<int> degrees1 = calculateDegrees(adjacencyMatrix1);
+                            cout << "Press Enter to generate random graphs..." << endl;
+                            cout << "------------------------------------------------------------------ \n";
+                            if (!input.readLine(inputLine))
+                                return 0;
+                            // Both graphs are relabeled copies of the user's own edges
+                            vector<pair<int, int>> copyEdges;
+                            vector<int> copyPermutations;
+                            generateIsomorphicCopies(userEdges, numVertices, 2, gen, copyEdges, copyPermutations);
+                            CsrGraph graph1 = buildCsrGraph(numVertices, copyEdges.data(), userEdges.size());
+
+                            vector<int> degrees1 = calculateDegrees(graph1);
                             vector<int> sortedVertices1;
                             sortVerticesByDegree(degrees1, sortedVertices1);
                             cout << "Sorted vertices by degree in ascending order (Random Graph 1):" << endl;
@@ -533,31 +523,35 @@ int main()
                             }
                             cout << "------------------------------------------------------------------" << endl;
 
-                            // Generate the second random graph with the same number of vertices and edges
-                            vector<vector<int>> adjacencyMatrix2 = adjacencyMatrix1; // Start with the same adjacency matrix
-                            shuffleVerticesWithSameEdges(adjacencyMatrix2); // Shuffle the vertices while preserving the edges
-                            // Create the dots for the second random graph
-                            vector<Vector2f> graph2Dots;
-                            for (int i = 0; i < numVertices; ++i)
+                            // The second random graph is the second copy in the batch, or half of the
+                            // time a relabeled distractor that is not isomorphic to the user's graph
+                            vector<vector<pair<int, int>>> distractors;
+                            {
+                                TRACE_SCOPE("wait for distractors");
+                                distractors = distractorBatch.get();
+                            }
+                            CsrGraph graph2;
+                            if (!distractors.empty() && bernoulli_distribution(0.5)(gen))
                             {
-                                int x = uniform_int_distribution<>(DotSpacing, MaxX - DotSpacing)(gen);
-                                int y = uniform_int_distribution<>(DotSpacing, MaxY - DotSpacing)(gen);
-                                graph2Dots.push_back(Vector2f(x, y));
+                                relabelEdges(distractors[0], vector<int>(copyPermutations.begin() + numVertices, copyPermutations.end()));
+                                graph2 = buildCsrGraph(numVertices, distractors[0]);
                             }
-                            // Create the lines for the second random graph based on the shuffled adjacency matrix
-                            vector<Line> graph2Lines;
-                            for (int i = 0; i < numVertices; ++i)
+                            else
                             {
-                                for (int j = i + 1; j < numVertices; ++j)
+                                graph2 = buildCsrGraph(numVertices, copyEdges.data() + userEdges.size(), userEdges.size());
+                            }
+                            // The puzzle is saved as a pair, ready for isomorphic_batch check
+                            if (saveGraphs)
+                            {
+                                for (const CsrGraph* graph : { &graph1, &graph2 })
                                 {
-                                    if (adjacencyMatrix2[i][j] == 1)
-                                    {
-                                        graph2Lines.push_back(Line(graph2Dots[i], graph2Dots[j], false));
-                                    }
+                                    vector<pair<int, int>> puzzleEdges;
+                                    forEachEdge(*graph, [&](int u, int v) { puzzleEdges.emplace_back(u, v); });
+                                    saveGraph(PuzzlesFile, GraphFormat::Sparse6, numVertices, puzzleEdges);
                                 }
                             }
                             vector<int> degrees2 =
-                                calculateDegrees(adjacencyMatrix2);
+                                calculateDegrees(graph2);
                             vector<int> sortedVertices2;
                             sortVerticesByDegree(degrees2, sortedVertices2);
 
@@ -567,36 +561,43 @@ int main()
                             }
                             cout << "------------------------------------------------------------------" << endl;
                             // Check for isomorphism with the first random graph (graph1)
-                            if (isIsomorphic(degrees, degrees1)) {
+                            vector<int> mapping1;
+                            if (isIsomorphic(userGraph, graph1, mapping1)) {
                                 cout << "User-Graph is isomorphic to Random Graph 1." << endl;
+                                for (int v = 0; v < numVertices; ++v)
+                                    cout << "Vertex " << v + 1 << " -> Vertex " << mapping1[v] + 1 << endl;
                             }
                             else {
                                 cout << "User-Graph is NOT isomorphic to Random Graph 1." << endl;
                             }
 
                             // Check for isomorphism with the second random graph (graph2)
-                            if (isIsomorphic(degrees, degrees2)) {
+                            vector<int> mapping2;
+                            if (isIsomorphic(userGraph, graph2, mapping2)) {
                                 cout << "User-Graph is isomorphic to Random Graph 2." << endl;
+                                for (int v = 0; v < numVertices; ++v)
+                                    cout << "Vertex " << v + 1 << " -> Vertex " << mapping2[v] + 1 << endl;
                             }
                             else {
                                 cout << "User-Graph is NOT isomorphic to Random Graph 2." << endl;
                             }
-                            while (window1.isOpen() && window2.isOpen()) {
-                                Event event1, event2;
-                                while (window1.pollEvent(event1)) {
-                                    if (event1.type == Event::Closed)
-                                        window1.close();
-                                }
-                                while (window2.pollEvent(event2)) {
-                                    if (event2.type == Event::Closed)
-                                        window2.close();
-                                }
-                                window1.clear();
-                                window2.clear();
-                                drawGraph(window1, graph1Dots, graph1Lines);
-                                drawGraph(window2, graph2Dots, graph2Lines);
-                                window1.display();
-                                window2.display();
+                            // One window per graph, each laid out, drawn and presented on its own threads;
+                            // drag to pan and scroll to zoom. The main thread only forwards events.
+                            vector<unique_ptr<ResultWindow>> resultWindows;
+                            resultWindows.emplace_back(new ResultWindow("Random Graph 1", make_shared<const CsrGraph>(move(graph1)),
+                                assets.path("font"), resultVertexStyle(), Color::Blue, gen, FrameRate, offscreen));
+                            resultWindows.emplace_back(new ResultWindow("Random Graph 2", make_shared<const CsrGraph>(move(graph2)),
+                                assets.path("font"), resultVertexStyle(), Color::Blue, gen, FrameRate, offscreen));
+                            auto allOpen = [&]() {
+                                for (const auto& resultWindow : resultWindows)
+                                    if (!resultWindow->isOpen())
+                                        return false;
+                                return true;
+                            };
+                            while (allOpen()) {
+                                for (size_t w = 0; w < resultWindows.size(); ++w)
+                                    resultWindows[w]->processEvents(input.events(1 + (int)w));
+                                sf::sleep(milliseconds(10));
                             }
                             return 0;
                         }
@@ -604,67 +605,55 @@ int main()
                     else
                     {
                         // Stop dragging any dot
-                        for (auto& dot : dots)
-                        {
-                            if (dot.isDragging)
-                            {
-                                dot.isDragging = false;
-                                dot.shape.setFillColor(Color::Yellow); // Reset the dot's color
-                            }
-                        }
+                        for (int i : draggedDots)
+                            board.setVertexColor(i, Color::Yellow); // Reset the dot's color
+                        draggedDots.clear();
                     }
                 }
                 else if (event.type == Event::MouseMoved)
                 {
-                    Vector2f mousePos = Vector2f(Mouse::getPosition(window));
-                    for (auto& dot : dots)
+                    Vector2f mousePos = boardCamera.toWorld(input.mousePosition(window, 0));
+                    if (!draggedDots.empty())
                     {
-                        if (dot.isDragging)
-                        {
-                            dot.shape.setPosition(mousePos);
-                            // Update the position of the label relative to the dot's position
-                            dot.label.setPosition(dot.shape.getPosition() + Vector2f(5, 2));
-                            break;
-                        }
+                        // The edges follow the dot
+                        int dragged = draggedDots[0];
+                        Vector2f center = mousePos + Vector2f(DotSize / 2, DotSize / 2);
+                        boardGraph.setPosition(dragged, center.x, center.y);
+                        board.setVertexPosition(dragged, center);
+                        indexDot(dragged);
+                        boardGraph.forEachIncidentEdge(dragged, indexEdge);
                     }
                 }
             }
+            boardPacer.setAnimating((drawingMode && isDrawing) || !draggedDots.empty());
+            if (!boardPacer.needsRedraw())
+                continue;
             if (drawingMode && isDrawing)
             {
-                endPos = Vector2f(Mouse::getPosition(window));
+                endPos = boardCamera.toWorld(input.mousePosition(window, 0));
             }
-            window.clear();
-            for (const auto& dot : dots)
             {
-                window.draw(dot.shape);
-                window.draw(dot.label); // Draw the number or alphabet label
-                for (const auto& curve : dot.curves)
+                TRACE_SCOPE("draw");
+                screen.clear();
+                screen.setView(boardCamera.getView());
+                screen.draw(board);
+                if (drawingMode && isDrawing)
                 {
-                    window.draw(curve);
+                    Vertex line[] =
+                    {
+                        Vertex(startPos, Color::Cyan),
+                        Vertex(endPos, Color::Cyan)
+                    };
+                    screen.draw(line, 2, Lines);
                 }
+                screen.setView(screen.getDefaultView());
+                screen.draw(instructionText);
             }
-            for (const auto& edge : edges)
-            {
-                window.draw(edge.line);
-                window.draw(edge.label); // Draw the edge label
-            }
-            if (drawingMode && isDrawing)
             {
-                Vertex line[] =
-                {
-                    Vertex(startPos, Color::Cyan),
-                    Vertex(endPos, Color::Cyan)
-                };
-                window.draw(line, 2, Lines);
+                TRACE_SCOPE("display");
+                present();
             }
-            Text instructionText;
-            instructionText.setFont(font);
-            instructionText.setString("INSTRUCTION:  Press the (SPACEBAR) to Switch to Move the Vertices\nor to Draw Edges. Press (L) and Click the Right Border of the Vertex\nto Create a Loop. Take Note That The Last Edge Shouldn't be a Loop.");
-            instructionText.setCharacterSize(20);
-            instructionText.setFillColor(Color::White);
-            instructionText.setPosition(10, 10);
-            window.draw(instructionText);
-            window.display();
+            boardPacer.frameDrawn();
         }
     }
     return 0;
@@ -0,0 +1,276 @@
+// Headless batch mode: generates and checks puzzles without SFML or interactive prompts,
+// so it can run on a server. Graphs use the formats described in graph_io.h.
+//
+// usage:
+//   isomorphic_batch check [-j threads] [--mapping] [file...]
+//       Reads graphs two at a time from the files (stdin when none or "-") and prints one
+//       line per pair: "<pair> isomorphic [mapping]" or "<pair> not-isomorphic". The
+//       format of each file is detected from its first byte; files are memory-mapped, so
+//       corpora of any size stream through.
+//   isomorphic_batch generate [-j threads] [--distractors] [--format f] <count> <vertices> <edges> [seed]
+//       Prints <count> puzzles, each a random graph followed by a shuffled copy, or with
+//       --distractors half of the time a same-degree-sequence graph that is not isomorphic.
+//       --format is text (the default), graph6, sparse6 or binary.
+//
+// Either mode takes --trace <file> to write a Chrome trace of the run (see trace.h).
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include "graph_io.h"
+#include "thread_pool.h"
+#include "trace.h"
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace std;
+
+// Pairs handed to a worker at a time; large enough that queueing is negligible.
+const int BatchSize = 1024;
+
+struct GraphText
+{
+    int numVertices;
+    vector<pair<int, int>> edges;
+};
+
+// Results are written in submission order while at most a couple of batches per worker
+// are in flight, so memory stays bounded however long the input is.
+class OrderedWriter
+{
+public:
+    OrderedWriter(ThreadPool& pool) : pool(pool) {}
+
+    template <typename Task>
+    void submit(Task task)
+    {
+        pending.push_back(pool.submit(std::move(task)));
+        while ((int)pending.size() > 2 * pool.size())
+            writeFront();
+    }
+
+    void finish()
+    {
+        while (!pending.empty())
+            writeFront();
+        fflush(stdout);
+    }
+
+private:
+    void writeFront()
+    {
+        string text = pending.front().get();
+        pending.pop_front();
+        fwrite(text.data(), 1, text.size(), stdout);
+    }
+
+    ThreadPool& pool;
+    deque<future<string>> pending;
+};
+
+string checkBatch(const vector<GraphText>& graphs, long long firstPair, bool printMapping)
+{
+    TRACE_SCOPE_ARG("checkBatch", "pairs", graphs.size() / 2);
+    string out;
+    vector<int> mapping;
+    for (size_t i = 0; i + 1 < graphs.size(); i += 2)
+    {
+        CsrGraph graph1 = buildCsrGraph(graphs[i].numVertices, graphs[i].edges);
+        CsrGraph graph2 = buildCsrGraph(graphs[i + 1].numVertices, graphs[i + 1].edges);
+        appendInteger(out, firstPair + i / 2 + 1);
+        if (isIsomorphic(graph1, graph2, mapping))
+        {
+            out += " isomorphic";
+            if (printMapping)
+            {
+                for (int v : mapping)
+                {
+                    out += ' ';
+                    appendInteger(out, v + 1);
+                }
+            }
+            out += '\n';
+        }
+        else
+        {
+            out += " not-isomorphic\n";
+        }
+    }
+    return out;
+}
+
+int check(const vector<string>& files, int numThreads, bool printMapping)
+{
+    ThreadPool pool(numThreads);
+    OrderedWriter writer(pool);
+    vector<GraphText> batch;
+    long long pairsSubmitted = 0;
+    auto flush = [&]() {
+        long long firstPair = pairsSubmitted;
+        pairsSubmitted += batch.size() / 2;
+        writer.submit([graphs = std::move(batch), firstPair, printMapping]() { return checkBatch(graphs, firstPair, printMapping); });
+        batch.clear();
+        };
+
+    for (const string& name : files)
+    {
+        // Regular files are mapped; stdin and anything else that cannot be is read buffered
+        unique_ptr<MappedFile> mapped;
+        FILE* file = nullptr;
+        if (name != "-")
+            mapped = make_unique<MappedFile>(name);
+        if (mapped == nullptr || !mapped->isOpen())
+        {
+            file = name == "-" ? stdin : fopen(name.c_str(), "rb");
+            if (file == nullptr)
+            {
+                cerr << "Failed to open " << name << endl;
+                return 1;
+            }
+        }
+#if defined(_WIN32)
+        if (file == stdin)
+            _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        GraphReader reader = file != nullptr ? GraphReader(file) : GraphReader(mapped->data(), mapped->size());
+        GraphText graph;
+        while (reader.read(graph.numVertices, graph.edges))
+        {
+            batch.push_back(std::move(graph));
+            if ((int)batch.size() == 2 * BatchSize)
+                flush();
+        }
+        if (file != nullptr && file != stdin)
+            fclose(file);
+        if (reader.failed())
+        {
+            writer.finish();
+            cerr << "Malformed graph in " << name << endl;
+            return 1;
+        }
+        if (batch.size() % 2 != 0)
+        {
+            writer.finish();
+            cerr << "Odd number of graphs in " << name << ", the last one has no partner" << endl;
+            return 1;
+        }
+    }
+    if (!batch.empty())
+        flush();
+    writer.finish();
+    return 0;
+}
+
+string generateBatch(int count, int numVertices, int numEdges, bool withDistractors, GraphFormat format, unsigned seed, long long batchIndex)
+{
+    TRACE_SCOPE_ARG("generateBatch", "puzzles", count);
+    seed_seq sequence{ seed, (unsigned)batchIndex, (unsigned)(batchIndex >> 32) };
+    mt19937 gen(sequence);
+    string out;
+    vector<pair<int, int>> edges;
+    for (int i = 0; i < count; ++i)
+    {
+        BitGraph graph = generateRandomGraph(numVertices, numEdges, gen);
+        edges.clear();
+        forEachEdge(graph, [&](int u, int v) { edges.emplace_back(u, v); });
+        appendGraph(out, format, numVertices, edges);
+
+        if (withDistractors && bernoulli_distribution(0.5)(gen))
+        {
+            vector<vector<pair<int, int>>> distractors = generateDistractors(numVertices, edges, 1, (unsigned)gen(), 1);
+            if (!distractors.empty())
+            {
+                vector<int> permutation;
+                randomPermutation(permutation, numVertices, gen);
+                relabelEdges(distractors[0], permutation);
+                appendGraph(out, format, numVertices, distractors[0]);
+                continue;
+            }
+        }
+        shuffleVerticesWithSameEdges(graph, gen);
+        edges.clear();
+        forEachEdge(graph, [&](int u, int v) { edges.emplace_back(u, v); });
+        appendGraph(out, format, numVertices, edges);
+    }
+    return out;
+}
+
+int generate(long long count, int numVertices, int numEdges, bool withDistractors, GraphFormat format, unsigned seed, int numThreads)
+{
+    long long maxEdges = (long long)numVertices * (numVertices - 1) / 2;
+    if (numVertices < 1 || numEdges < 0 || numEdges > maxEdges)
+    {
+        cerr << "A simple graph with " << numVertices << " vertices has at most " << maxEdges << " edges" << endl;
+        return 1;
+    }
+#if defined(_WIN32)
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    string header;
+    appendGraphStreamHeader(header, format);
+    fwrite(header.data(), 1, header.size(), stdout);
+
+    ThreadPool pool(numThreads);
+    OrderedWriter writer(pool);
+    for (long long first = 0, batchIndex = 0; first < count; first += BatchSize, ++batchIndex)
+    {
+        int size = (int)min<long long>(BatchSize, count - first);
+        writer.submit([=]() { return generateBatch(size, numVertices, numEdges, withDistractors, format, seed, batchIndex); });
+    }
+    writer.finish();
+    return 0;
+}
+
+int usage()
+{
+    cerr << "usage: isomorphic_batch check [-j threads] [--mapping] [--trace file] [file...]" << endl;
+    cerr << "       isomorphic_batch generate [-j threads] [--distractors] [--format f] [--trace file] <count> <vertices> <edges> [seed]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        return usage();
+    string mode = argv[1];
+    int numThreads = 0;
+    bool printMapping = false, withDistractors = false;
+    const char* traceFile = nullptr;
+    GraphFormat format = GraphFormat::Text;
+    vector<string> arguments;
+    for (int i = 2; i < argc; ++i)
+    {
+        string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (argument == "--mapping")
+            printMapping = true;
+        else if (argument == "--distractors")
+            withDistractors = true;
+        else if (argument == "--format" && i + 1 < argc)
+        {
+            if (!parseGraphFormat(argv[++i], format))
+                return usage();
+        }
+        else if (argument == "--trace" && i + 1 < argc)
+            traceFile = argv[++i];
+        else
+            arguments.push_back(argument);
+    }
+
+    TraceSession traceSession(traceFile);
+    if (mode == "check")
+    {
+        if (arguments.empty())
+            arguments.push_back("-");
+        return check(arguments, numThreads, printMapping);
+    }
+    if (mode == "generate" && (arguments.size() == 3 || arguments.size() == 4))
+    {
+        unsigned seed = arguments.size() == 4 ? (unsigned)stoul(arguments[3]) : random_device()();
+        return generate(stoll(arguments[0]), stoi(arguments[1]), stoi(arguments[2]), withDistractors, format, seed, numThreads);
+    }
+    return usage();
+}
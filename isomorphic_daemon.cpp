@@ -0,0 +1,467 @@
+// Isomorphism service on a local Unix domain socket, for using the graph core as a backend.
+// A client connects, writes graphs in any format GraphReader detects (graph6, sparse6,
+// binary or text, see graph_io.h), and shuts down its side of the connection to end the
+// request. The daemon answers which of the graphs are isomorphic to each other.
+//
+// Graphs are first split into buckets by vertex count, edge count and degree sequence, which
+// every isomorphism preserves; each bucket is then resolved exactly on a work-stealing pool,
+// a pair with one isIsomorphic check and larger buckets by canonical form, computed in
+// parallel. Every isomorphism class is sent back as soon as its bucket is done:
+//
+//     class 1 4 7
+//     class 2
+//     ...
+//     done <graphs> <classes>
+//
+// Graphs are numbered from 1 in the order they were sent; classes of one bucket are written
+// together, buckets in whatever order they finish. A malformed request, one over the size
+// limits below or one the daemon fails on gets a line "error <reason>" instead.
+//
+// usage:
+//   isomorphic_daemon serve [-j threads] [--trace file] <socket>
+//   isomorphic_daemon query <socket> [file]
+//       Sends the file (stdin when none or "-") as one request and prints the answer.
+//
+// Unix domain sockets make this POSIX-only.
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <csignal>
+#include <stdexcept>
+#include "graph_io.h"
+#include "work_stealing_pool.h"
+#include "trace.h"
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+
+using namespace std;
+
+// Graphs per parallelFor task when a bucket is canonized; enough that one task outweighs
+// the cost of queueing it.
+const int CanonicalGrain = 16;
+
+// Request limits, so one client cannot take the daemon's memory: vertices and edges of any
+// one graph, graphs per request, and vertices plus edges summed over the request. The
+// vertex limit is low because the exact search keeps up to n - 1 automorphism generators of
+// n entries each, so a highly symmetric graph (an empty one, say) costs O(n^2) memory.
+const int MaxGraphVertices = 1 << 12;
+const long long MaxGraphEdges = 1 << 24;
+const int MaxRequestGraphs = 1 << 22;
+const long long MaxRequestSize = 1LL << 26;
+
+// A send that makes no progress for this long ends the connection, so a client that stops
+// reading cannot keep its thread and graphs alive forever.
+const int SendTimeoutSeconds = 30;
+
+#if !defined(_WIN32)
+
+volatile sig_atomic_t stopRequested = 0;
+
+// The socket being served, for removal when the daemon dies on a fatal signal.
+char socketPath[sizeof(sockaddr_un::sun_path)];
+
+// Connections being served; each runs on its own detached thread.
+mutex connectionMutex;
+condition_variable connectionClosed;
+int openConnections = 0;
+
+void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+// SIGABRT (also what an uncaught exception ends in), SIGSEGV and the like: the socket file
+// goes, then the signal takes its default course.
+void removeSocketAndDie(int signalNumber)
+{
+    unlink(socketPath);
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+// Writes everything, retrying short writes; false once the peer has gone or the send
+// timeout has run out.
+bool sendAll(int socket, const string& text)
+{
+    size_t sent = 0;
+    while (sent < text.size())
+    {
+        ssize_t n = send(socket, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool connectTo(const string& path, int& socketOut)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof address.sun_path)
+        return false;
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    socketOut = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketOut < 0)
+        return false;
+    if (connect(socketOut, (sockaddr*)&address, sizeof address) == 0)
+        return true;
+    close(socketOut);
+    return false;
+}
+
+// Vertex count, edge count and the sorted degree sequence, hashed like a certificate.
+struct BucketKeyHash
+{
+    size_t operator()(const vector<int>& key) const { return (size_t)hashCertificate(key); }
+};
+
+// Classes of one bucket, one line each, graphs numbered from 1.
+string resolveBucket(const vector<CsrGraph>& graphs, const vector<int>& members, WorkStealingPool& pool, int& numClasses)
+{
+    TRACE_SCOPE_ARG("resolveBucket", "graphs", members.size());
+    vector<vector<int>> classes;
+    if (members.size() == 1)
+    {
+        classes.push_back(members);
+    }
+    else if (members.size() == 2)
+    {
+        vector<int> mapping;
+        if (isIsomorphic(graphs[members[0]], graphs[members[1]], mapping))
+            classes.push_back(members);
+        else
+            classes = { { members[0] }, { members[1] } };
+    }
+    else
+    {
+        int count = (int)members.size();
+        vector<CanonicalForm> forms(count);
+        pool.parallelFor((count + CanonicalGrain - 1) / CanonicalGrain, [&](int chunk) {
+            int end = min(count, (chunk + 1) * CanonicalGrain);
+            for (int i = chunk * CanonicalGrain; i < end; ++i)
+                forms[i] = canonicalForm(graphs[members[i]]);
+            });
+        unordered_map<vector<int>, int, BucketKeyHash> classOf;
+        for (int i = 0; i < count; ++i)
+        {
+            auto inserted = classOf.emplace(std::move(forms[i].certificate), (int)classes.size());
+            if (inserted.second)
+                classes.emplace_back();
+            classes[inserted.first->second].push_back(members[i]);
+        }
+    }
+
+    string out;
+    for (const auto& isomorphicGraphs : classes)
+    {
+        out += "class";
+        for (int index : isomorphicGraphs)
+        {
+            out += ' ';
+            appendInteger(out, index + 1);
+        }
+        out += '\n';
+    }
+    numClasses = (int)classes.size();
+    return out;
+}
+
+// Answers one request; throws if it cannot. The caller owns and closes the socket.
+void serveConnection(int client, WorkStealingPool& pool)
+{
+    TRACE_SCOPE("serveConnection");
+    int readSide = dup(client);
+    unique_ptr<FILE, int (*)(FILE*)> in(readSide >= 0 ? fdopen(readSide, "rb") : nullptr, fclose);
+    if (in == nullptr)
+    {
+        if (readSide >= 0)
+            close(readSide);
+        throw runtime_error("cannot read the request");
+    }
+    vector<CsrGraph> graphs;
+    GraphReader reader(in.get());
+    {
+        TRACE_SCOPE("read request");
+        long long sizeLeft = MaxRequestSize;
+        int numVertices;
+        vector<pair<int, int>> edges;
+        for (;;)
+        {
+            reader.setLimits(min<long long>(MaxGraphVertices, sizeLeft), min(MaxGraphEdges, sizeLeft));
+            if (!reader.read(numVertices, edges))
+                break;
+            sizeLeft -= numVertices + (long long)edges.size();
+            if (sizeLeft < 0 || (int)graphs.size() == MaxRequestGraphs)
+            {
+                sendAll(client, "error request too large\n");
+                return;
+            }
+            graphs.push_back(buildCsrGraph(numVertices, edges));
+        }
+    }
+    in.reset();
+    if (reader.exceededLimits())
+    {
+        sendAll(client, "error request too large\n");
+        return;
+    }
+    if (reader.failed())
+    {
+        sendAll(client, "error malformed graph after " + to_string(graphs.size()) + " graphs\n");
+        return;
+    }
+
+    unordered_map<vector<int>, vector<int>, BucketKeyHash> buckets;
+    {
+        TRACE_SCOPE_ARG("bucket", "graphs", graphs.size());
+        for (int i = 0; i < (int)graphs.size(); ++i)
+        {
+            vector<int> key = calculateDegrees(graphs[i]);
+            sort(key.begin(), key.end());
+            key.push_back(graphs[i].numVertices);
+            key.push_back((int)graphs[i].neighbors.size());
+            buckets[std::move(key)].push_back(i);
+        }
+    }
+
+    // Each bucket queues its classes as soon as it is resolved and this thread sends them,
+    // so a slow reader holds up only its own connection, never a pool worker. The tasks
+    // refer to this frame, so it is left only once every task that was queued has finished.
+    mutex doneMutex;
+    condition_variable bucketDone;
+    vector<string> resolved; // classes waiting to be sent
+    size_t bucketsLeft = 0;
+    long long totalClasses = 0;
+    string failure;
+    for (auto& bucket : buckets)
+    {
+        const vector<int>* members = &bucket.second;
+        {
+            lock_guard<mutex> lock(doneMutex);
+            ++bucketsLeft;
+        }
+        try
+        {
+            pool.submit([&, members]() {
+                string out;
+                int numClasses = 0;
+                string error;
+                try
+                {
+                    out = resolveBucket(graphs, *members, pool, numClasses);
+                }
+                catch (const exception& e)
+                {
+                    error = e.what();
+                }
+                lock_guard<mutex> lock(doneMutex);
+                if (!error.empty() && failure.empty())
+                    failure = error;
+                try
+                {
+                    resolved.push_back(std::move(out));
+                }
+                catch (const exception& e)
+                {
+                    if (failure.empty())
+                        failure = e.what();
+                }
+                totalClasses += numClasses;
+                --bucketsLeft;
+                bucketDone.notify_one();
+                });
+        }
+        catch (const exception& e)
+        {
+            lock_guard<mutex> lock(doneMutex);
+            --bucketsLeft;
+            failure = e.what();
+            break;
+        }
+    }
+
+    bool connected = true;
+    vector<string> sending;
+    unique_lock<mutex> lock(doneMutex);
+    for (;;)
+    {
+        bucketDone.wait(lock, [&] { return bucketsLeft == 0 || !resolved.empty(); });
+        if (resolved.empty())
+            break;
+        sending.swap(resolved);
+        // Once a bucket has failed the answer is incomplete, so nothing more is sent
+        connected = connected && failure.empty();
+        lock.unlock();
+        for (const string& out : sending)
+            connected = connected && sendAll(client, out);
+        sending.clear();
+        lock.lock();
+    }
+    if (!failure.empty())
+        throw runtime_error(failure);
+    if (connected)
+        sendAll(client, "done " + to_string(graphs.size()) + " " + to_string(totalClasses) + "\n");
+}
+
+void runConnection(int client, WorkStealingPool& pool)
+{
+    try
+    {
+        serveConnection(client, pool);
+    }
+    catch (const exception& e)
+    {
+        sendAll(client, string("error ") + e.what() + "\n");
+    }
+    close(client);
+    lock_guard<mutex> lock(connectionMutex);
+    --openConnections;
+    connectionClosed.notify_all();
+}
+
+int serve(const string& path, int numThreads)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof address.sun_path)
+    {
+        cerr << "Socket path too long: " << path << endl;
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str()); // left behind by a daemon that did not shut down cleanly
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof address) != 0 || listen(listener, 64) != 0)
+    {
+        cerr << "Failed to listen on " << path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    // No SA_RESTART, so a signal interrupts accept() and the loop can end
+    struct sigaction action {};
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    memcpy(socketPath, path.c_str(), path.size() + 1);
+    for (int fatal : { SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL })
+        signal(fatal, removeSocketAndDie);
+
+    WorkStealingPool pool(numThreads);
+    cerr << "Listening on " << path << " with " << pool.size() << " threads" << endl;
+    while (!stopRequested)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            cerr << "accept failed: " << strerror(errno) << endl;
+            break;
+        }
+        timeval sendTimeout{};
+        sendTimeout.tv_sec = SendTimeoutSeconds;
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+        {
+            lock_guard<mutex> lock(connectionMutex);
+            ++openConnections;
+        }
+        try
+        {
+            thread(runConnection, client, ref(pool)).detach();
+        }
+        catch (const exception& e)
+        {
+            sendAll(client, string("error ") + e.what() + "\n");
+            close(client);
+            lock_guard<mutex> lock(connectionMutex);
+            --openConnections;
+        }
+    }
+    close(listener);
+    unlink(path.c_str());
+    // Requests already accepted are answered before the pool goes away
+    unique_lock<mutex> lock(connectionMutex);
+    connectionClosed.wait(lock, [] { return openConnections == 0; });
+    return 0;
+}
+
+int query(const string& path, const string& fileName)
+{
+    int server;
+    if (!connectTo(path, server))
+    {
+        cerr << "Failed to connect to " << path << endl;
+        return 1;
+    }
+    FILE* file = fileName == "-" ? stdin : fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        cerr << "Failed to open " << fileName << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    vector<char> buffer(1 << 16);
+    bool sent = true;
+    size_t length;
+    while (sent && (length = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+        sent = sendAll(server, string(buffer.data(), length));
+    if (file != stdin)
+        fclose(file);
+    shutdown(server, SHUT_WR); // the end of the request
+    ssize_t received;
+    while ((received = recv(server, buffer.data(), buffer.size(), 0)) > 0)
+        fwrite(buffer.data(), 1, received, stdout);
+    close(server);
+    return sent ? 0 : 1;
+}
+
+#endif
+
+int usage()
+{
+    cerr << "usage: isomorphic_daemon serve [-j threads] [--trace file] <socket>" << endl;
+    cerr << "       isomorphic_daemon query <socket> [file]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        return usage();
+    string mode = argv[1];
+    int numThreads = 0;
+    const char* traceFile = nullptr;
+    vector<string> arguments;
+    for (int i = 2; i < argc; ++i)
+    {
+        string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (argument == "--trace" && i + 1 < argc)
+            traceFile = argv[++i];
+        else
+            arguments.push_back(argument);
+    }
+#if defined(_WIN32)
+    cerr << "isomorphic_daemon needs Unix domain sockets and runs on POSIX systems only" << endl;
+    return 1;
+#else
+    if (mode == "serve" && arguments.size() == 1)
+    {
+        TraceSession traceSession(traceFile);
+        return serve(arguments[0], numThreads);
+    }
+    if (mode == "query" && (arguments.size() == 1 || arguments.size() == 2))
+        return query(arguments[0], arguments.size() == 2 ? arguments[1] : "-");
+    return usage();
+#endif
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Distractor generation for the board puzzle, started before the user has finished drawing.
+// As soon as one edge is missing, the distractors of every graph the last edge could
+// complete are queued on a thread pool, so when the final edge arrives its batch is
+// usually ready. The batches of the other completions are dropped before they start.
+// Both paths generate with the same seed and thread count and put the final edge smaller
+// vertex first, so a finished graph gets the same distractors whether or not its batch was
+// speculative, and a replay matches its recording.
+
+#include <atomic>
+#include <map>
+#include "graph.h"
+#include "thread_pool.h"
+
+class PuzzleSpeculator
+{
+public:
+    typedef vector<vector<pair<int, int>>> Distractors;
+
+    PuzzleSpeculator(int numVertices, int numDistractors, unsigned seed, int numThreads = 0)
+        : numVertices(numVertices), numDistractors(numDistractors), seed(seed), pool(numThreads) {}
+
+    // Call after every edge with all edges so far and the number the graph will have. The
+    // last edge is assumed not to be a loop, as the board asks.
+    void update(const vector<pair<int, int>>& edges, int numEdges)
+    {
+        if ((int)edges.size() != numEdges - 1 || speculated)
+            return;
+        speculated = true;
+        prefixSize = edges.size();
+        for (int u = 0; u < numVertices; ++u)
+        {
+            for (int v = u + 1; v < numVertices; ++v)
+            {
+                int index = (int)pending.size();
+                vector<pair<int, int>> candidate = edges;
+                candidate.emplace_back(u, v);
+                pending.emplace(make_pair(u, v), pool.submit([this, index, candidate]() {
+                    int wanted = chosen.load();
+                    if (wanted != NoneChosen && wanted != index)
+                        return Distractors();
+                    return generateDistractors(this->numVertices, candidate, this->numDistractors, seed, ThreadsPerBatch);
+                    }));
+            }
+        }
+    }
+
+    // The distractors of the finished graph: the speculative batch if there is one, otherwise
+    // a batch started now.
+    future<Distractors> take(const vector<pair<int, int>>& edges)
+    {
+        if (speculated && edges.size() == prefixSize + 1 && edges.back().first != edges.back().second)
+        {
+            auto key = make_pair(min(edges.back().first, edges.back().second), max(edges.back().first, edges.back().second));
+            auto it = pending.find(key);
+            chosen = (int)distance(pending.begin(), it);
+            future<Distractors> batch = std::move(it->second);
+            pending.clear();
+            return batch;
+        }
+        chosen = NoneWanted;
+        pending.clear();
+        // Distractors depend on edge orientation, so the final edge is ordered as the
+        // speculative candidates order it
+        vector<pair<int, int>> finished = edges;
+        if (!finished.empty() && finished.back().first > finished.back().second)
+            swap(finished.back().first, finished.back().second);
+        return pool.submit([this, finished]() { return generateDistractors(numVertices, finished, numDistractors, seed, ThreadsPerBatch); });
+    }
+
+private:
+    static const int NoneChosen = -1;
+    static const int NoneWanted = -2;
+    // The pool runs many batches at once, so each uses one thread
+    static const int ThreadsPerBatch = 1;
+
+    int numVertices;
+    int numDistractors;
+    unsigned seed;
+    bool speculated = false;
+    size_t prefixSize = 0;
+    map<pair<int, int>, future<Distractors>> pending; // by last edge, in submission order
+    atomic<int> chosen{ NoneChosen };
+    ThreadPool pool;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+// A result window that renders on its own thread. The thread that created the window keeps
+// handling its events (SFML requires this on some platforms) and hands view changes over;
+// a layout thread advances the force layout and hands position snapshots over; the render
+// thread owns the window's GL context and draws whenever either handoff has something new.
+// All handoffs are lock-free triple buffers, so a slow or vsync-blocked window never stalls
+// another, and any number of windows can be open side by side. An offscreen window stays
+// hidden and renders into a texture of the same size instead, for timing runs.
+//
+// Every window loads its own copy of the label font: sf::Font rasterizes glyphs into its
+// cache and texture on first use and is not thread-safe, so render threads cannot share one.
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "camera.h"
+#include "force_layout.h"
+#include "graph_renderer.h"
+#include "trace.h"
+#include "triple_buffer.h"
+
+class ResultWindow
+{
+public:
+    // Labels are left out if fontFile cannot be loaded.
+    ResultWindow(const string& title, shared_ptr<const CsrGraph> graph, const string& fontFile, const VertexStyle& style,
+        sf::Color edgeColor, mt19937& gen, unsigned framesPerSecond = 60, bool offscreen = false)
+        : title(title), graph(std::move(graph)), hasFont(font.loadFromFile(fontFile)), style(style), edgeColor(edgeColor), offscreen(offscreen),
+        window(sf::VideoMode(800, 600), title), camera(window, sf::Mouse::Left),
+        layout(*this->graph, 800, 600, 35, gen), frameTime(sf::microseconds(1000000 / max(1u, framesPerSecond)))
+    {
+        window.setVerticalSyncEnabled(!offscreen);
+        if (offscreen)
+            window.setVisible(false);
+        publishPositions();
+        views.back() = camera.getView();
+        views.publish();
+        // The context moves to the render thread
+        window.setActive(false);
+        renderThread = thread(&ResultWindow::renderLoop, this);
+        layoutThread = thread(&ResultWindow::layoutLoop, this);
+    }
+
+    ResultWindow(const ResultWindow&) = delete;
+    ResultWindow& operator=(const ResultWindow&) = delete;
+
+    ~ResultWindow() { close(); }
+
+    bool isOpen() const { return !closed; }
+
+    // Call from the thread that created the window.
+    void processEvents() { processEvents(LiveEvents()); }
+
+    // Same, with events taken from `events` (see FramePacer::nextEvent).
+    template <typename Events>
+    void processEvents(Events events)
+    {
+        sf::Event event;
+        while (!closed && events.poll(window, event))
+        {
+            if (event.type == sf::Event::Closed)
+            {
+                close();
+                return;
+            }
+            if (camera.handleEvent(event))
+            {
+                views.back() = camera.getView();
+                views.publish();
+            }
+            else if (event.type == sf::Event::GainedFocus || event.type == sf::Event::Resized)
+            {
+                repaint = true;
+            }
+        }
+    }
+
+    void close()
+    {
+        if (closed)
+            return;
+        closed = true;
+        stopping = true;
+        if (layoutThread.joinable())
+            layoutThread.join();
+        if (renderThread.joinable())
+            renderThread.join();
+        window.close();
+    }
+
+private:
+    struct LiveEvents
+    {
+        bool poll(sf::Window& window, sf::Event& event) { return window.pollEvent(event); }
+    };
+
+    void publishPositions()
+    {
+        vector<sf::Vector2f>& positions = snapshots.back();
+        positions.resize(layout.numVertices());
+        for (int v = 0; v < layout.numVertices(); ++v)
+            positions[v] = sf::Vector2f(layout.positionX(v), layout.positionY(v));
+        snapshots.publish();
+    }
+
+    // One layout iteration per frame, so the graph visibly untangles.
+    void layoutLoop()
+    {
+        traceThreadName("layout: " + title);
+        sf::Clock clock;
+        while (!stopping && !layout.converged())
+        {
+            clock.restart();
+            layout.step();
+            publishPositions();
+            sf::Int64 remaining = frameTime.asMicroseconds() - clock.getElapsedTime().asMicroseconds();
+            if (remaining > 0)
+                sf::sleep(sf::microseconds(remaining));
+        }
+    }
+
+    void renderLoop()
+    {
+        traceThreadName("render: " + title);
+        window.setActive(true);
+        sf::RenderTexture texture;
+        if (offscreen)
+            texture.create(window.getSize().x, window.getSize().y);
+        sf::RenderTarget& target = offscreen ? (sf::RenderTarget&)texture : window;
+        GraphRenderer renderer(hasFont ? &font : nullptr, style);
+        renderer.setEdgeColor(edgeColor);
+        snapshots.update();
+        for (const auto& position : snapshots.front())
+            renderer.addVertex(position);
+        forEachEdge(*graph, [&](int i, int j) { renderer.addEdge(i, j); });
+        bool changed = true;
+        while (!stopping)
+        {
+            if (snapshots.update())
+            {
+                const vector<sf::Vector2f>& positions = snapshots.front();
+                for (int v = 0; v < (int)positions.size(); ++v)
+                    renderer.setVertexPosition(v, positions[v]);
+                changed = true;
+            }
+            if (views.update())
+            {
+                target.setView(views.front());
+                changed = true;
+            }
+            if (repaint.exchange(false))
+                changed = true;
+            if (!changed)
+            {
+                sf::sleep(frameTime);
+                continue;
+            }
+            {
+                TRACE_SCOPE("draw");
+                target.clear();
+                target.draw(renderer);
+            }
+            {
+                TRACE_SCOPE("display");
+                if (offscreen)
+                    texture.display();
+                else
+                    window.display();
+            }
+            changed = false;
+        }
+        window.setActive(false);
+    }
+
+    string title;
+    shared_ptr<const CsrGraph> graph; // immutable, shared with whoever created the window
+    sf::Font font; // this window's own, used by the render thread only
+    bool hasFont;
+    VertexStyle style;
+    sf::Color edgeColor;
+    bool offscreen;
+    sf::RenderWindow window;
+    Camera camera;
+    ForceLayout layout; // used by the layout thread only
+    sf::Time frameTime;
+    TripleBuffer<vector<sf::Vector2f>> snapshots;
+    TripleBuffer<sf::View> views;
+    atomic<bool> repaint{ false };
+    atomic<bool> stopping{ false };
+    bool closed = false;
+    thread renderThread;
+    thread layoutThread;
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+// Uniform grid over vertex boxes and edge segments for mouse hit testing. Space is cut into
+// square cells and every item is listed in the cells it overlaps, so a point query only
+// looks at the items of one cell (or the few cells within the pick tolerance) instead of
+// scanning the whole board. Cells live in a hash map, so coordinates are unbounded.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cellSize = 64.0f) : cellSize(cellSize) {}
+
+    // Inserts vertex `id` or moves it to a new box.
+    void setVertex(int id, float left, float top, float right, float bottom)
+    {
+        if (id >= (int)boxes.size())
+            boxes.resize(id + 1);
+        Box& box = boxes[id];
+        if (box.valid)
+            forEachCell(box.left, box.top, box.right, box.bottom, [&](uint64_t key) { erase(vertexCells[key], id); });
+        box = Box{ left, top, right, bottom, true };
+        forEachCell(left, top, right, bottom, [&](uint64_t key) { vertexCells[key].push_back(id); });
+    }
+
+    void removeVertex(int id)
+    {
+        if (id >= (int)boxes.size() || !boxes[id].valid)
+            return;
+        Box& box = boxes[id];
+        forEachCell(box.left, box.top, box.right, box.bottom, [&](uint64_t key) { erase(vertexCells[key], id); });
+        box.valid = false;
+    }
+
+    // The highest-numbered vertex whose box contains the point, or -1.
+    int vertexAt(float x, float y) const
+    {
+        int found = -1;
+        auto it = vertexCells.find(cellKey(cellIndex(x), cellIndex(y)));
+        if (it == vertexCells.end())
+            return -1;
+        for (int id : it->second)
+        {
+            if (id > found && boxes[id].contains(x, y))
+                found = id;
+        }
+        return found;
+    }
+
+    // Every vertex whose box contains the point, in increasing order.
+    vector<int> verticesAt(float x, float y) const
+    {
+        vector<int> found;
+        auto it = vertexCells.find(cellKey(cellIndex(x), cellIndex(y)));
+        if (it == vertexCells.end())
+            return found;
+        for (int id : it->second)
+        {
+            if (boxes[id].contains(x, y))
+                found.push_back(id);
+        }
+        sort(found.begin(), found.end());
+        return found;
+    }
+
+    // Every vertex whose box overlaps the rectangle, in increasing order.
+    vector<int> verticesIn(float left, float top, float right, float bottom) const
+    {
+        vector<int> found;
+        forEachCell(left, top, right, bottom, [&](uint64_t key) {
+            auto it = vertexCells.find(key);
+            if (it == vertexCells.end())
+                return;
+            for (int id : it->second)
+            {
+                const Box& box = boxes[id];
+                if (box.left <= right && box.right >= left && box.top <= bottom && box.bottom >= top)
+                    found.push_back(id);
+            }
+            });
+        sort(found.begin(), found.end());
+        found.erase(unique(found.begin(), found.end()), found.end());
+        return found;
+    }
+
+    // Adds one straight piece of edge `id`; a curved edge is added as several pieces.
+    void addSegment(int id, float x1, float y1, float x2, float y2)
+    {
+        int index;
+        if (freeSegments.empty())
+        {
+            index = (int)segments.size();
+            segments.push_back(Segment{ x1, y1, x2, y2, id });
+        }
+        else
+        {
+            index = freeSegments.back();
+            freeSegments.pop_back();
+            segments[index] = Segment{ x1, y1, x2, y2, id };
+        }
+        if (id >= (int)segmentsOf.size())
+            segmentsOf.resize(id + 1);
+        segmentsOf[id].push_back(index);
+        traverseSegment(x1, y1, x2, y2, [&](uint64_t key) {
+            vector<int>& cell = segmentCells[key];
+            if (cell.empty() || cell.back() != index)
+                cell.push_back(index);
+            });
+    }
+
+    // Removes every piece of edge `id`, e.g. before adding it again where it moved to.
+    void removeSegments(int id)
+    {
+        if (id >= (int)segmentsOf.size())
+            return;
+        for (int index : segmentsOf[id])
+        {
+            const Segment& segment = segments[index];
+            traverseSegment(segment.x1, segment.y1, segment.x2, segment.y2, [&](uint64_t key) { erase(segmentCells[key], index); });
+            freeSegments.push_back(index);
+        }
+        segmentsOf[id].clear();
+    }
+
+    // The edge with a piece closest to the point within `tolerance`, or -1.
+    int segmentAt(float x, float y, float tolerance) const
+    {
+        int found = -1;
+        float best = tolerance * tolerance;
+        forEachCell(x - tolerance, y - tolerance, x + tolerance, y + tolerance, [&](uint64_t key) {
+            auto it = segmentCells.find(key);
+            if (it == segmentCells.end())
+                return;
+            for (int index : it->second)
+            {
+                float distance2 = segments[index].distance2(x, y);
+                if (distance2 <= best)
+                {
+                    best = distance2;
+                    found = segments[index].id;
+                }
+            }
+            });
+        return found;
+    }
+
+private:
+    struct Box
+    {
+        float left = 0, top = 0, right = 0, bottom = 0;
+        bool valid = false;
+
+        bool contains(float x, float y) const { return valid && x >= left && x < right && y >= top && y < bottom; }
+    };
+
+    struct Segment
+    {
+        float x1, y1, x2, y2;
+        int id;
+
+        float distance2(float x, float y) const
+        {
+            float dx = x2 - x1, dy = y2 - y1;
+            float length2 = dx * dx + dy * dy;
+            float t = length2 > 0 ? ((x - x1) * dx + (y - y1) * dy) / length2 : 0;
+            t = max(0.0f, min(1.0f, t));
+            float ex = x1 + t * dx - x, ey = y1 + t * dy - y;
+            return ex * ex + ey * ey;
+        }
+    };
+
+    int cellIndex(float coordinate) const { return (int)floor(coordinate / cellSize); }
+
+    static uint64_t cellKey(int cx, int cy) { return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy; }
+
+    static void erase(vector<int>& cell, int id)
+    {
+        auto it = find(cell.begin(), cell.end(), id);
+        if (it != cell.end())
+        {
+            *it = cell.back();
+            cell.pop_back();
+        }
+    }
+
+    template <typename Visitor>
+    void forEachCell(float left, float top, float right, float bottom, Visitor visit) const
+    {
+        for (int cx = cellIndex(left); cx <= cellIndex(right); ++cx)
+        {
+            for (int cy = cellIndex(top); cy <= cellIndex(bottom); ++cy)
+                visit(cellKey(cx, cy));
+        }
+    }
+
+    // Visits the cells the segment passes through, walking from cell to cell along it
+    // (Amanatides-Woo) so long edges do not claim their whole bounding box.
+    template <typename Visitor>
+    void traverseSegment(float x1, float y1, float x2, float y2, Visitor visit) const
+    {
+        int cx = cellIndex(x1), cy = cellIndex(y1);
+        int endX = cellIndex(x2), endY = cellIndex(y2);
+        float dx = x2 - x1, dy = y2 - y1;
+        int stepX = dx > 0 ? 1 : -1, stepY = dy > 0 ? 1 : -1;
+        float tDeltaX = dx != 0 ? cellSize / fabs(dx) : INFINITY;
+        float tDeltaY = dy != 0 ? cellSize / fabs(dy) : INFINITY;
+        float nextX = (cx + (stepX > 0 ? 1 : 0)) * cellSize, nextY = (cy + (stepY > 0 ? 1 : 0)) * cellSize;
+        float tMaxX = dx != 0 ? (nextX - x1) / dx : INFINITY;
+        float tMaxY = dy != 0 ? (nextY - y1) / dy : INFINITY;
+        int steps = abs(endX - cx) + abs(endY - cy);
+        visit(cellKey(cx, cy));
+        for (int i = 0; i < steps; ++i)
+        {
+            if (tMaxX < tMaxY)
+            {
+                cx += stepX;
+                tMaxX += tDeltaX;
+            }
+            else
+            {
+                cy += stepY;
+                tMaxY += tDeltaY;
+            }
+            visit(cellKey(cx, cy));
+        }
+    }
+
+    float cellSize;
+    vector<Box> boxes;
+    vector<Segment> segments;
+    vector<vector<int>> segmentsOf; // pieces of each edge id
+    vector<int> freeSegments; // slots of removed pieces
+    unordered_map<uint64_t, vector<int>> vertexCells;
+    unordered_map<uint64_t, vector<int>> segmentCells;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+// Fixed-size pool of worker threads fed from a single FIFO queue. Tasks are submitted as
+// callables and their results come back through futures.
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+class ThreadPool
+{
+public:
+    // All cores when numThreads is 0.
+    explicit ThreadPool(int numThreads = 0)
+    {
+        if (numThreads <= 0)
+            numThreads = max(1u, thread::hardware_concurrency());
+        for (int t = 0; t < numThreads; ++t)
+            workers.emplace_back([this] { run(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Finishes every queued task before joining.
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    int size() const { return (int)workers.size(); }
+
+    template <typename Task>
+    auto submit(Task task) -> future<decltype(task())>
+    {
+        // packaged_task is move-only and function<> needs a copyable target
+        auto packaged = make_shared<packaged_task<decltype(task())()>>(std::move(task));
+        future<decltype(task())> result = packaged->get_future();
+        {
+            lock_guard<mutex> lock(queueMutex);
+            tasks.emplace([packaged] { (*packaged)(); });
+        }
+        queueReady.notify_one();
+        return result;
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable queueReady;
+    bool stopping = false;
+};
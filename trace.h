@@ -0,0 +1,291 @@
+#pragma once
+
+// Scoped-span tracing for finding where frame time and puzzle latency go. TRACE_SCOPE marks
+// the rest of the enclosing block as a span; TRACE_INSTANT marks a point in time and
+// TRACE_COUNTER a value over time. Every thread records into its own ring buffer, so
+// recording takes no lock shared with other threads, and when a buffer is full the oldest
+// events are overwritten. writeChromeTrace() writes everything recorded so far as Chrome
+// trace JSON, which chrome://tracing and ui.perfetto.dev open as a flame view.
+//
+// Tracing is off until startTracing() is called; until then every macro costs one atomic
+// load and a branch. Building with -DNO_TRACING removes the macros entirely.
+//
+// Event names and argument names must be string literals (or otherwise outlive the trace),
+// since only the pointers are stored.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct TraceEvent
+{
+    const char* name;
+    const char* argName; // nullptr when the event has no argument
+    int64_t arg;
+    int64_t start;    // ns since startTracing()
+    int64_t duration; // ns, spans only
+    char phase;       // 'X' span, 'i' instant, 'C' counter, as in the trace format
+};
+
+class TraceBuffer
+{
+public:
+    static constexpr size_t Capacity = 1 << 16; // events kept per thread
+
+    explicit TraceBuffer(int threadId) : threadId(threadId), events(Capacity) {}
+
+    void push(const TraceEvent& event)
+    {
+        lock_guard<mutex> lock(bufferMutex); // only contended while a trace is written
+        events[written++ & (Capacity - 1)] = event;
+    }
+
+    void setName(const string& name)
+    {
+        lock_guard<mutex> lock(bufferMutex);
+        threadName = name;
+    }
+
+    // The surviving events, oldest first.
+    void snapshot(vector<TraceEvent>& out, string& name)
+    {
+        lock_guard<mutex> lock(bufferMutex);
+        size_t count = min<size_t>(written, Capacity);
+        for (size_t i = written - count; i < written; ++i)
+            out.push_back(events[i & (Capacity - 1)]);
+        name = threadName;
+    }
+
+    const int threadId;
+
+private:
+    mutex bufferMutex;
+    vector<TraceEvent> events;
+    size_t written = 0;
+    string threadName;
+};
+
+// Process-wide trace state. Buffers are shared with their threads, so the events of a
+// thread that has already exited are still written out.
+struct TraceRegistry
+{
+    atomic<bool> enabled{ false };
+    chrono::steady_clock::time_point epoch;
+    mutex registryMutex;
+    vector<shared_ptr<TraceBuffer>> buffers;
+};
+
+inline TraceRegistry& traceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline bool traceEnabled()
+{
+    return traceRegistry().enabled.load(memory_order_acquire);
+}
+
+inline void startTracing()
+{
+    TraceRegistry& registry = traceRegistry();
+    registry.epoch = chrono::steady_clock::now();
+    registry.enabled.store(true);
+}
+
+inline void stopTracing()
+{
+    traceRegistry().enabled.store(false);
+}
+
+inline int64_t traceNow()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceRegistry().epoch).count();
+}
+
+inline TraceBuffer& threadTraceBuffer()
+{
+    thread_local shared_ptr<TraceBuffer> buffer;
+    if (!buffer)
+    {
+        TraceRegistry& registry = traceRegistry();
+        lock_guard<mutex> lock(registry.registryMutex);
+        buffer = make_shared<TraceBuffer>((int)registry.buffers.size() + 1);
+        registry.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Names the calling thread in the trace ("main", "render", ...). Does nothing while
+// tracing is off, so untraced threads never allocate a buffer; a thread named before
+// tracing starts stays unnamed.
+inline void traceThreadName(const string& name)
+{
+    if (!traceEnabled())
+        return;
+    threadTraceBuffer().setName(name);
+}
+
+inline void traceInstant(const char* name, const char* argName, int64_t arg)
+{
+    threadTraceBuffer().push(TraceEvent{ name, argName, arg, traceNow(), 0, 'i' });
+}
+
+inline void traceCounter(const char* name, int64_t value)
+{
+    threadTraceBuffer().push(TraceEvent{ name, "value", value, traceNow(), 0, 'C' });
+}
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, const char* argName = nullptr, int64_t arg = 0)
+        : name(name), argName(argName), arg(arg), start(traceEnabled() ? traceNow() : -1) {}
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan()
+    {
+        if (start >= 0)
+            threadTraceBuffer().push(TraceEvent{ name, argName, arg, start, traceNow() - start, 'X' });
+    }
+
+private:
+    const char* name;
+    const char* argName;
+    int64_t arg;
+    int64_t start; // -1 when tracing was off as the span began
+};
+
+inline void appendJsonString(string& out, const char* text)
+{
+    out += '"';
+    for (; *text; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            out += '\\';
+        if ((unsigned char)*text >= 0x20)
+            out += *text;
+    }
+    out += '"';
+}
+
+// Writes every event recorded so far; returns false if the file cannot be written.
+inline bool writeChromeTrace(const string& fileName)
+{
+    vector<shared_ptr<TraceBuffer>> buffers;
+    {
+        TraceRegistry& registry = traceRegistry();
+        lock_guard<mutex> lock(registry.registryMutex);
+        buffers = registry.buffers;
+    }
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    string out = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    char number[96];
+    vector<TraceEvent> events;
+    string threadName;
+    for (const auto& buffer : buffers)
+    {
+        events.clear();
+        buffer->snapshot(events, threadName);
+        if (!threadName.empty())
+        {
+            snprintf(number, sizeof number, "{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\", \"args\": {\"name\": ", buffer->threadId);
+            out += first ? "" : ",\n";
+            out += number;
+            appendJsonString(out, threadName.c_str());
+            out += "}}";
+            first = false;
+        }
+        for (const TraceEvent& event : events)
+        {
+            out += first ? "" : ",\n";
+            first = false;
+            out += "{\"name\": ";
+            appendJsonString(out, event.name);
+            // Timestamps are in microseconds; three decimals keep nanoseconds
+            snprintf(number, sizeof number, ", \"ph\": \"%c\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f", event.phase, buffer->threadId, event.start / 1000.0);
+            out += number;
+            if (event.phase == 'X')
+            {
+                snprintf(number, sizeof number, ", \"dur\": %.3f", event.duration / 1000.0);
+                out += number;
+            }
+            else if (event.phase == 'i')
+            {
+                out += ", \"s\": \"t\"";
+            }
+            if (event.argName != nullptr)
+            {
+                out += ", \"args\": {";
+                appendJsonString(out, event.argName);
+                snprintf(number, sizeof number, ": %lld}", (long long)event.arg);
+                out += number;
+            }
+            out += '}';
+            if (out.size() > (1 << 20))
+            {
+                fwrite(out.data(), 1, out.size(), file);
+                out.clear();
+            }
+        }
+    }
+    out += "\n]}\n";
+    fwrite(out.data(), 1, out.size(), file);
+    return fclose(file) == 0;
+}
+
+// Starts tracing for its lifetime when given a file name, and writes the trace there when
+// it goes out of scope. Declared first in main(), it outlives every traced thread.
+class TraceSession
+{
+public:
+    explicit TraceSession(const char* fileName) : fileName(fileName ? fileName : "")
+    {
+        if (this->fileName.empty())
+            return;
+        startTracing();
+        traceThreadName("main");
+    }
+
+    ~TraceSession()
+    {
+        if (fileName.empty())
+            return;
+        stopTracing();
+        if (!writeChromeTrace(fileName))
+            fprintf(stderr, "Failed to write trace to %s\n", fileName.c_str());
+    }
+
+private:
+    string fileName;
+};
+
+#ifdef NO_TRACING
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, argName, arg) ((void)0)
+#define TRACE_INSTANT(name, argName, arg) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#else
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, arg) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, argName, (int64_t)(arg))
+#define TRACE_INSTANT(name, argName, arg) \
+    do { if (traceEnabled()) traceInstant(name, argName, (int64_t)(arg)); } while (0)
+#define TRACE_COUNTER(name, value) \
+    do { if (traceEnabled()) traceCounter(name, (int64_t)(value)); } while (0)
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+// Lock-free single-producer, single-consumer handoff of the latest value. The producer
+// fills back() and publishes it; the consumer picks up the newest published value with
+// update() and reads it through front() for as long as it likes. Neither side ever waits
+// for the other, and values the consumer did not get to in time are simply skipped.
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Producer side.
+    T& back() { return buffers[backIndex]; }
+
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | FreshBit, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Consumer side. Returns true if a value newer than front() was published.
+    bool update()
+    {
+        if ((middle.load(std::memory_order_acquire) & FreshBit) == 0)
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    const T& front() const { return buffers[frontIndex]; }
+
+private:
+    static const int FreshBit = 4;
+    static const int IndexMask = 3;
+
+    T buffers[3];
+    std::atomic<int> middle{ 1 };
+    int backIndex = 0;
+    int frontIndex = 2;
+};
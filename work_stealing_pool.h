@@ -0,0 +1,212 @@
+#pragma once
+
+// Pool of worker threads that each own a deque of tasks. A worker takes its own tasks from
+// the back, newest first, so work it just split off is still in its cache; a worker whose
+// deque is empty steals from the front of another's, where the oldest and usually largest
+// tasks wait. Tasks submitted from outside the pool are dealt out round-robin.
+//
+// parallelFor() splits a loop into tasks on the calling worker's deque and runs tasks
+// itself until the loop is done, so a big job spreads over idle workers and no worker sits
+// blocked on work it could be doing.
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+
+class WorkStealingPool
+{
+public:
+    // All cores when numThreads is 0.
+    explicit WorkStealingPool(int numThreads = 0)
+    {
+        if (numThreads <= 0)
+            numThreads = max(1u, thread::hardware_concurrency());
+        for (int t = 0; t < numThreads; ++t)
+            queues.push_back(make_unique<WorkerQueue>());
+        for (int t = 0; t < numThreads; ++t)
+            workers.emplace_back([this, t] { run(t); });
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Finishes every queued task, including ones queued by running tasks, before joining.
+    ~WorkStealingPool()
+    {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        workReady.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    int size() const { return (int)workers.size(); }
+
+    // Queues a task on the calling worker's own deque, or on the next one in turn when
+    // called from outside the pool. The task must not throw; nothing would receive it.
+    void submit(function<void()> task)
+    {
+        int index = currentWorker();
+        if (index < 0)
+            index = (int)(nextQueue++ % queues.size());
+        {
+            lock_guard<mutex> lock(queues[index]->dequeMutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            ++queued;
+        }
+        workReady.notify_one();
+    }
+
+    // Calls body(i) for every i in [0, count) and returns when all calls have. Calls other
+    // than the first may run on any worker; meanwhile the caller runs queued tasks, which
+    // may belong to other jobs. If calls throw, the first exception is rethrown here once
+    // all calls are done.
+    void parallelFor(int count, const function<void(int)>& body)
+    {
+        if (count <= 0)
+            return;
+        atomic<int> remaining{ count };
+        mutex errorMutex;
+        exception_ptr error;
+        auto call = [&](int i) {
+            try
+            {
+                body(i);
+            }
+            catch (...)
+            {
+                lock_guard<mutex> lock(errorMutex);
+                if (!error)
+                    error = current_exception();
+            }
+            remaining.fetch_sub(1, memory_order_release);
+            };
+        for (int i = count - 1; i > 0; --i)
+        {
+            try
+            {
+                submit([&call, i] { call(i); });
+            }
+            catch (...)
+            {
+                // Calls 1..i were never queued; the queued ones still refer to this frame
+                {
+                    lock_guard<mutex> lock(errorMutex);
+                    if (!error)
+                        error = current_exception();
+                }
+                remaining.fetch_sub(i, memory_order_release);
+                break;
+            }
+        }
+        call(0);
+
+        function<void()> task;
+        while (remaining.load(memory_order_acquire) > 0)
+        {
+            if (takeTask(currentWorker(), task))
+                task();
+            else
+                this_thread::yield(); // the last calls are running elsewhere
+        }
+        if (error)
+            rethrow_exception(error);
+    }
+
+private:
+    struct WorkerQueue
+    {
+        mutex dequeMutex;
+        deque<function<void()>> tasks;
+    };
+
+    // Index of the calling thread among this pool's workers, -1 for any other thread.
+    int currentWorker() const
+    {
+        return workerPool == this ? workerIndex : -1;
+    }
+
+    // The newest task of worker `index`, or else the oldest task of the first other worker
+    // that has one, starting after `index` so thieves spread out.
+    bool takeTask(int index, function<void()>& task)
+    {
+        int numQueues = (int)queues.size();
+        if (index >= 0 && popTask(index, task, true))
+            return true;
+        for (int k = 1; k <= numQueues; ++k)
+        {
+            int victim = (max(index, 0) + k) % numQueues;
+            if (victim != index && popTask(victim, task, false))
+                return true;
+        }
+        return false;
+    }
+
+    bool popTask(int index, function<void()>& task, bool fromBack)
+    {
+        WorkerQueue& queue = *queues[index];
+        lock_guard<mutex> lock(queue.dequeMutex);
+        if (queue.tasks.empty())
+            return false;
+        if (fromBack)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        lock_guard<mutex> sleepLock(sleepMutex);
+        --queued;
+        return true;
+    }
+
+    void run(int index)
+    {
+        workerPool = this;
+        workerIndex = index;
+        function<void()> task;
+        for (;;)
+        {
+            if (takeTask(index, task))
+            {
+                task();
+                continue;
+            }
+            unique_lock<mutex> lock(sleepMutex);
+            workReady.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+
+    static thread_local const WorkStealingPool* workerPool;
+    static thread_local int workerIndex;
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+    atomic<unsigned> nextQueue{ 0 };
+    mutex sleepMutex; // guards queued and stopping
+    condition_variable workReady;
+    long long queued = 0; // tasks in any deque
+    bool stopping = false;
+};
+
+inline thread_local const WorkStealingPool* WorkStealingPool::workerPool = nullptr;
+inline thread_local int WorkStealingPool::workerIndex = -1;